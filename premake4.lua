@@ -19,6 +19,18 @@
 -- or
 -- @loader_path/../Libraries @loader_path/../Libraries/opencv3
 
+newoption
+{
+   trigger = "avx",
+   description = "Build the ray tracer SIMD kernels for AVX instead of SSE2"
+}
+
+newoption
+{
+   trigger = "stats",
+   description = "Count the BVH nodes, box tests and primitive tests of the ray tracer, for its heatmaps"
+}
+
 -- A solution contains projects, and defines the available configurations
 solution "pihlaja"
    configurations { "Debug", "Release" }
@@ -107,6 +119,89 @@ solution "pihlaja"
          }
          linkoptions { "-stdlib=libc++", "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo" }
 
+      configuration { "avx", "not windows" }
+         buildoptions { "-mavx" }
+
+      configuration { "avx", "windows" }
+         buildoptions { "/arch:AVX" }
+
+      configuration { "stats" }
+         defines { "RAE_RAY_STATS" }
+
+      configuration "Debug"
+         defines { "DEBUG" }
+         flags { "Symbols" }
+         debugdir "bin/"
+
+      configuration "Release"
+         defines { "NDEBUG" }
+         flags { "Optimize" }
+         debugdir "bin/"
+
+   -- The ray tracer without a window or an OpenGL context, as a command line tool. The materials
+   -- and meshes still include the GL headers, so these link GLEW and NanoVG.
+   local function rayTracerConsoleApp(name)
+      project(name)
+      kind "ConsoleApp"
+      language "C++"
+      targetdir "bin/"
+      files
+      {
+         "src/" .. name .. "/**.cpp",
+         "src/rae/core/Random.cpp",
+         "src/rae/core/ThreadPool.cpp",
+         "src/rae/core/Types.cpp",
+         "src/rae/core/Utils.cpp",
+         "src/rae/image/ImageBuffer.cpp",
+         "src/rae/visual/Box.cpp",
+         "src/rae/visual/Camera.cpp",
+         "src/rae/visual/Material.cpp",
+         "src/rae/visual/Mesh.cpp",
+         "src/rae/visual/Transform.cpp",
+         "src/rae_ray/**.hpp",
+         "src/rae_ray/**.cpp"
+      }
+      excludes
+      {
+         "src/rae_ray/RayTracer.*",
+         "src/**Test.cpp"
+      }
+      includedirs
+      {
+         "external/glew/include",
+         "external/nanovg/src",
+         "external/glm",
+         "external/glm/glm",
+         "src/",
+         "src/rae",
+         "src/rae_ray",
+         "external/",
+         "external/stb"
+      }
+      links { "glew", "nanovg", "assimp" }
+      defines { "GLEW_STATIC", "NANOVG_GLEW" }
+
+      configuration { "linux" }
+         buildoptions { "-std=c++11" }
+         links { "GL", "pthread" }
+
+      configuration { "windows" }
+         links { "opengl32", "psapi" }
+
+      configuration { "macosx" }
+         buildoptions { "-std=c++11 -stdlib=libc++" }
+         libdirs { "../Libraries/" }
+         linkoptions { "-stdlib=libc++", "-framework OpenGL" }
+
+      configuration { "avx", "not windows" }
+         buildoptions { "-mavx" }
+
+      configuration { "avx", "windows" }
+         buildoptions { "/arch:AVX" }
+
+      configuration { "stats" }
+         defines { "RAE_RAY_STATS" }
+
       configuration "Debug"
          defines { "DEBUG" }
          flags { "Symbols" }
@@ -116,6 +211,13 @@ solution "pihlaja"
          defines { "NDEBUG" }
          flags { "Optimize" }
          debugdir "bin/"
+   end
+
+   -- Renders a scene to PNG and PFM files: rae_render --help
+   rayTracerConsoleApp("rae_render")
+
+   -- Times the scenes with fixed settings and compares them to a baseline: rae_benchmark --help
+   rayTracerConsoleApp("rae_benchmark")
 
    -- GLFW Library
    project "glfw3"
@@ -62,6 +62,14 @@ Engine::Engine(GLFWwindow* window) :
 
 	createTestWorld2();
 
+	EntityTables entityTables;
+	entityTables.transforms = &m_transformSystem.transforms();
+	entityTables.meshLinks = &m_renderSystem.meshLinks();
+	entityTables.materialLinks = &m_renderSystem.materialLinks();
+	entityTables.meshes = &m_assetSystem.meshes();
+	entityTables.materials = &m_assetSystem.materials();
+	m_rayTracer.setEntityTables(entityTables);
+
 	using std::placeholders::_1;
 	m_input.connectMouseButtonPressEventHandler(std::bind(&Engine::onMouseEvent, this, _1));
 	m_input.connectKeyEventHandler(std::bind(&Engine::onKeyEvent, this, _1));
@@ -438,9 +446,18 @@ void Engine::onKeyEvent(const Input& input)
 			case KeySym::Y: m_rayTracer.toggleBufferQuality(); break;
 			case KeySym::U: m_rayTracer.toggleFastMode(); break;
 			case KeySym::H: m_rayTracer.toggleVisualizeFocusDistance(); break;
+			case KeySym::J: m_rayTracer.cycleSampler(); break;
+			case KeySym::T: m_rayTracer.toggleLightSampling(); break;
+			case KeySym::X: m_rayTracer.toggleAdaptiveSampling(); break;
+			case KeySym::C: m_rayTracer.cycleDisplayMode(); break;
+			case KeySym::Z: m_rayTracer.toggleDenoising(); break;
+			case KeySym::comma: m_rayTracer.toggleReprojection(); break;
+			case KeySym::period: m_rayTracer.toggleDynamicResolution(); break;
 			case KeySym::_1: m_rayTracer.showScene(1); break;
 			case KeySym::_2: m_rayTracer.showScene(2); break;
 			case KeySym::_3: m_rayTracer.showScene(3); break;
+			case KeySym::_4: m_rayTracer.showScene(4); break;
+			case KeySym::_5: m_rayTracer.showScene(5); break;
 			default:
 			break;
 		}
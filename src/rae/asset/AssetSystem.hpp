@@ -36,6 +36,9 @@ public:
 	Material& getMaterial(Id id);
 	bool isMaterial(Id id) { return m_materials.check(id); }
 
+	const Table<Mesh>& meshes() const { return m_meshes; }
+	const Table<Material>& materials() const { return m_materials; }
+
 	int meshCount() { return m_meshes.size(); }
 	int materialCount() { return m_materials.size(); }
 
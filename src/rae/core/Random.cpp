@@ -6,40 +6,57 @@
 namespace rae
 {
 
-RandomGeneratorEngine g_randomEngine;
+static uint64_t splitMix64(uint64_t value)
+{
+	value += 0x9e3779b97f4a7c15ULL;
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+uint64_t hashRandomSeed(uint64_t seed, uint64_t a, uint64_t b)
+{
+	return splitMix64(splitMix64(splitMix64(seed) ^ a) ^ b);
+}
+
+Pcg32& threadRandom()
+{
+	static thread_local Pcg32 random;
+	return random;
+}
+
+void seedThreadRandom(uint64_t seed, int pixelIndex, int sampleIndex)
+{
+	threadRandom().setSeed(hashRandomSeed(seed, uint64_t(pixelIndex), uint64_t(sampleIndex)));
+}
 
 #ifdef _WIN32
 double drand48()
 {
-	return getRandom(0.0, 1.0);
+	return getRandom();
 }
 #endif
 
 float getRandom()
 {
-#ifdef _WIN32
-	return getRandom( 0.0f, 1.0f );
-#else
-	return drand48();
-#endif
+	return threadRandom().nextFloat();
 }
 
 float getRandom( float from, float to )
 {
-	static std::uniform_real_distribution<float> uniform_dist;
-	return uniform_dist( g_randomEngine, std::uniform_real_distribution<float>::param_type(from, to) );
+	return from + (to - from) * threadRandom().nextFloat();
 }
 
 float getRandomDistribution(float mean, float deviation)
 {
-	static std::normal_distribution<float> normal_dist(mean, deviation);
-	return normal_dist(g_randomEngine, std::normal_distribution<float>::param_type(mean, deviation));
+	std::normal_distribution<float> normal_dist(mean, deviation);
+	return normal_dist(threadRandom());
 }
 
 int getRandomInt( int from, int to )
 {
-	static std::uniform_int_distribution<int> uniform_dist;
-	return uniform_dist( g_randomEngine, std::uniform_int_distribution<int>::param_type(from, to) );
+	std::uniform_int_distribution<int> uniform_dist(from, to);
+	return uniform_dist(threadRandom());
 }
 
 } // end namespace rae
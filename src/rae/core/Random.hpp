@@ -1,13 +1,68 @@
 #pragma once
 
+#include <stdint.h>
 #include <random>
 #include <algorithm>
 
 namespace rae
 {
 
-typedef std::mt19937 RandomGeneratorEngine;
-extern RandomGeneratorEngine g_randomEngine;
+// PCG32 (pcg-random.org). A small and fast generator with 64 bits of state, that can be
+// seeded cheaply for every pixel sample. Also works as a std random engine.
+class Pcg32
+{
+public:
+	typedef uint32_t result_type;
+
+	Pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL)
+	{
+		setSeed(seed, stream);
+	}
+
+	void setSeed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbULL)
+	{
+		m_state = 0u;
+		m_increment = (stream << 1u) | 1u;
+		nextUint();
+		m_state += seed;
+		nextUint();
+	}
+
+	uint32_t nextUint()
+	{
+		uint64_t oldState = m_state;
+		m_state = oldState * 6364136223846793005ULL + m_increment;
+		uint32_t xorShifted = uint32_t(((oldState >> 18u) ^ oldState) >> 27u);
+		uint32_t rotation = uint32_t(oldState >> 59u);
+		return (xorShifted >> rotation) | (xorShifted << ((-rotation) & 31));
+	}
+
+	// In [0, 1). The top 24 bits, so that the result can't round up to 1.
+	float nextFloat()
+	{
+		return float(nextUint() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	static constexpr result_type min() { return 0u; }
+	static constexpr result_type max() { return UINT32_MAX; }
+	result_type operator()() { return nextUint(); }
+
+protected:
+	uint64_t m_state;
+	uint64_t m_increment;
+};
+
+// Mixes the numbers to a well distributed 64 bit hash (splitmix64 finalizer).
+uint64_t hashRandomSeed(uint64_t seed, uint64_t a, uint64_t b = 0);
+
+// The generator of the calling thread. All the random functions below use it, so they
+// can be called from many threads at once.
+Pcg32& threadRandom();
+
+// Seeds the generator of the calling thread for one sample of one pixel. The numbers
+// only depend on the seed, pixel and sample, not on which thread renders the pixel,
+// so a render with a fixed seed is the same with any number of threads.
+void seedThreadRandom(uint64_t seed, int pixelIndex, int sampleIndex);
 
 #ifdef _WIN32
 double drand48();
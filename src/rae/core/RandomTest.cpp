@@ -0,0 +1,92 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "rae/core/Random.hpp"
+#include "rae/core/ThreadPool.hpp"
+
+using namespace rae;
+
+// Something like a path tracer does per pixel: seed, then draw a varying amount of numbers.
+static std::vector<float> renderNoise(ThreadPool& pool, uint64_t seed, int width, int height, int sample)
+{
+	std::vector<float> image(width * height, 0.0f);
+	pool.parallelFor(0, height, 1, [&](int begin, int end)
+	{
+		for (int y = begin; y < end; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				seedThreadRandom(seed, y * width + x, sample);
+				float value = 0.0f;
+				int bounces = getRandomInt(1, 8);
+				for (int i = 0; i < bounces; ++i)
+				{
+					value += getRandom(-1.0f, 1.0f);
+				}
+				image[y * width + x] = value;
+			}
+		}
+	});
+	return image;
+}
+
+SCENARIO("Random unittest", "[rae][Random]")
+{
+	GIVEN( "Pcg32 generators" )
+	{
+		THEN( "floats are in [0, 1) and the same seed gives the same numbers" )
+		{
+			Pcg32 first(12345, 6);
+			Pcg32 second(12345, 6);
+			Pcg32 otherStream(12345, 7);
+
+			bool inRange = true;
+			bool same = true;
+			int differentFromOtherStream = 0;
+			double sum = 0.0;
+			const int count = 100000;
+			for (int i = 0; i < count; ++i)
+			{
+				float value = first.nextFloat();
+				if (value < 0.0f || value >= 1.0f)
+					inRange = false;
+				if (value != second.nextFloat())
+					same = false;
+				if (value != otherStream.nextFloat())
+					differentFromOtherStream++;
+				sum += value;
+			}
+			REQUIRE(inRange == true);
+			REQUIRE(same == true);
+			REQUIRE(differentFromOtherStream > count - 10);
+			REQUIRE(std::abs(sum / count - 0.5) < 0.01);
+		}
+	}
+
+	GIVEN( "a noise image seeded per pixel and sample" )
+	{
+		ThreadPool singleThread(0);
+		ThreadPool manyThreads(3);
+
+		THEN( "it is bit identical with any number of threads" )
+		{
+			std::vector<float> reference = renderNoise(singleThread, 42, 64, 48, 3);
+			REQUIRE((reference == renderNoise(manyThreads, 42, 64, 48, 3)));
+			REQUIRE((reference == renderNoise(getThreadPool(), 42, 64, 48, 3)));
+		}
+
+		THEN( "other seeds and samples give other images" )
+		{
+			std::vector<float> reference = renderNoise(singleThread, 42, 64, 48, 3);
+			REQUIRE((reference != renderNoise(singleThread, 43, 64, 48, 3)));
+			REQUIRE((reference != renderNoise(singleThread, 42, 64, 48, 4)));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+// Compile time selection of the instruction set for the SIMD kernels of the ray tracer.
+// AVX is used when the compiler targets it (premake4 --avx, or -mavx / -march=native),
+// otherwise SSE2, which every x64 CPU has. Define RAE_SIMD_SCALAR to use the scalar fallback,
+// which is also what you get on other architectures.
+
+#if !defined(RAE_SIMD_SCALAR)
+	#if defined(__AVX__)
+		#define RAE_SIMD_AVX
+		#include <immintrin.h>
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define RAE_SIMD_SSE
+		#include <emmintrin.h>
+	#else
+		#define RAE_SIMD_SCALAR
+	#endif
+#endif
+
+namespace rae
+{
+
+#if defined(RAE_SIMD_AVX)
+
+const int SimdWidth = 8;
+const char* const SimdName = "AVX";
+
+// Eight floats. Comparisons return masks with all bits set in the lanes where they are true.
+struct SimdFloat
+{
+	SimdFloat() {}
+	SimdFloat(__m256 set) : v(set) {}
+	explicit SimdFloat(float set) : v(_mm256_set1_ps(set)) {}
+
+	static SimdFloat load(const float* from) { return _mm256_loadu_ps(from); }
+	void store(float* to) const { _mm256_storeu_ps(to, v); }
+
+	__m256 v;
+};
+
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a.v, b.v); }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return _mm256_sub_ps(a.v, b.v); }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a.v, b.v); }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return _mm256_div_ps(a.v, b.v); }
+inline SimdFloat operator<(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline SimdFloat operator>(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline SimdFloat operator<=(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline SimdFloat operator>=(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline SimdFloat operator&(SimdFloat a, SimdFloat b) { return _mm256_and_ps(a.v, b.v); }
+inline SimdFloat operator|(SimdFloat a, SimdFloat b) { return _mm256_or_ps(a.v, b.v); }
+inline SimdFloat squareRoot(SimdFloat a) { return _mm256_sqrt_ps(a.v); }
+// Takes a where mask is set and b elsewhere.
+inline SimdFloat blend(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+// One bit per lane from a comparison mask.
+inline int moveMask(SimdFloat mask) { return _mm256_movemask_ps(mask.v); }
+
+#elif defined(RAE_SIMD_SSE)
+
+const int SimdWidth = 4;
+const char* const SimdName = "SSE2";
+
+// Four floats. Comparisons return masks with all bits set in the lanes where they are true.
+struct SimdFloat
+{
+	SimdFloat() {}
+	SimdFloat(__m128 set) : v(set) {}
+	explicit SimdFloat(float set) : v(_mm_set1_ps(set)) {}
+
+	static SimdFloat load(const float* from) { return _mm_loadu_ps(from); }
+	void store(float* to) const { _mm_storeu_ps(to, v); }
+
+	__m128 v;
+};
+
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return _mm_add_ps(a.v, b.v); }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a.v, b.v); }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a.v, b.v); }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return _mm_div_ps(a.v, b.v); }
+inline SimdFloat operator<(SimdFloat a, SimdFloat b) { return _mm_cmplt_ps(a.v, b.v); }
+inline SimdFloat operator>(SimdFloat a, SimdFloat b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline SimdFloat operator<=(SimdFloat a, SimdFloat b) { return _mm_cmple_ps(a.v, b.v); }
+inline SimdFloat operator>=(SimdFloat a, SimdFloat b) { return _mm_cmpge_ps(a.v, b.v); }
+inline SimdFloat operator&(SimdFloat a, SimdFloat b) { return _mm_and_ps(a.v, b.v); }
+inline SimdFloat operator|(SimdFloat a, SimdFloat b) { return _mm_or_ps(a.v, b.v); }
+inline SimdFloat squareRoot(SimdFloat a) { return _mm_sqrt_ps(a.v); }
+// Takes a where mask is set and b elsewhere.
+inline SimdFloat blend(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+// One bit per lane from a comparison mask.
+inline int moveMask(SimdFloat mask) { return _mm_movemask_ps(mask.v); }
+
+#else
+
+// No SimdFloat, the kernels use their scalar loops.
+const int SimdWidth = 1;
+const char* const SimdName = "scalar";
+
+#endif
+
+}
@@ -0,0 +1,284 @@
+#include "rae/core/ThreadPool.hpp"
+
+#include <algorithm>
+
+using namespace rae;
+
+namespace
+{
+	// Which pool and queue the current thread works for. Threads outside any pool have nullptr here.
+	thread_local const ThreadPool* t_pool = nullptr;
+	thread_local int t_queueIndex = -1;
+
+	int g_threadPoolWorkerCount = -1;
+}
+
+ThreadPool& rae::getThreadPool()
+{
+	static ThreadPool pool(g_threadPoolWorkerCount);
+	return pool;
+}
+
+void rae::setThreadPoolWorkerCount(int workerCount)
+{
+	g_threadPoolWorkerCount = workerCount;
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+TaskGroup::TaskGroup() :
+	TaskGroup(getThreadPool())
+{
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) :
+	m_pool(pool),
+	m_pending(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	wait();
+}
+
+void TaskGroup::run(std::function<void()> func)
+{
+	m_pending++;
+
+	ThreadPool::Task task;
+	task.func = std::move(func);
+	task.group = this;
+	m_pool.push(std::move(task));
+}
+
+void TaskGroup::wait()
+{
+	while (m_pending > 0)
+	{
+		// Help with our own tasks instead of blocking. This is what makes nested groups safe.
+		if (m_pool.runPendingTask(this))
+			continue;
+
+		// The rest are running on other threads. Any tasks they add go to their own queues,
+		// and they run them themselves if no one steals them first.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_finished.wait(lock, [this]()
+		{
+			return m_pending == 0;
+		});
+	}
+
+	// The last task may still be notifying. Once it lets go of the mutex the group can be destroyed.
+	std::lock_guard<std::mutex> lock(m_mutex);
+}
+
+void TaskGroup::finishTask()
+{
+	// Only the last task takes the lock.
+	int pending = m_pending;
+	while (pending > 1)
+	{
+		if (m_pending.compare_exchange_weak(pending, pending - 1))
+			return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pending--;
+	m_finished.notify_all();
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+ThreadPool::ThreadPool(int workerCount) :
+	m_queuedTasks(0),
+	m_stop(false)
+{
+	if (workerCount < 0)
+	{
+		const int threadCountHint = (int)std::thread::hardware_concurrency();
+		workerCount = (threadCountHint == 0 ? 8 : threadCountHint) - 1;
+	}
+
+	m_queues.resize(workerCount + 1);
+
+	m_workers.reserve(workerCount);
+	for (int i = 0; i < workerCount; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wakeUp.notify_all();
+
+	for (auto&& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+int ThreadPool::defaultGrainSize(int itemCount) const
+{
+	// Around eight chunks per thread is enough for stealing to even out the load
+	// without paying too much for the task overhead.
+	return std::max(1, itemCount / (concurrency() * 8));
+}
+
+void ThreadPool::parallelFor(int start, int end, int grainSize, const std::function<void(int, int)>& func)
+{
+	if (end <= start)
+		return;
+
+	if (grainSize <= 0)
+		grainSize = defaultGrainSize(end - start);
+
+	if (end - start <= grainSize || workerCount() == 0)
+	{
+		func(start, end);
+		return;
+	}
+
+	TaskGroup group(*this);
+	splitRange(group, start, end, grainSize, func);
+	group.wait();
+}
+
+void ThreadPool::splitRange(TaskGroup& group, int begin, int end, int grainSize,
+	const std::function<void(int, int)>& func)
+{
+	// Give away the upper halves and keep on splitting the lower half until it is small enough.
+	while (end - begin > grainSize)
+	{
+		const int middle = begin + (end - begin) / 2;
+		group.run([this, &group, middle, end, grainSize, &func]()
+		{
+			splitRange(group, middle, end, grainSize, func);
+		});
+		end = middle;
+	}
+
+	func(begin, end);
+}
+
+int ThreadPool::queueIndexForThisThread() const
+{
+	if (t_pool == this)
+		return t_queueIndex;
+	return (int)m_queues.size() - 1; // The shared queue
+}
+
+void ThreadPool::push(Task&& task)
+{
+	WorkQueue& queue = m_queues[queueIndexForThisThread()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	m_queuedTasks++;
+	{
+		// Taking the lock orders this with a worker that is just about to sleep, so the wakeup is not lost.
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeUp.notify_one();
+}
+
+bool ThreadPool::popTask(Task& task, const TaskGroup* group)
+{
+	const int ownIndex = queueIndexForThisThread();
+	const int queueCount = (int)m_queues.size();
+
+	// Newest task from our own queue first, it is the most likely to be in the cache.
+	if (popTaskFrom(m_queues[ownIndex], task, group, /*isNewest*/true))
+		return true;
+
+	// Then steal the oldest, which are the biggest ranges, from the others.
+	for (int i = 1; i < queueCount; ++i)
+	{
+		if (popTaskFrom(m_queues[(ownIndex + i) % queueCount], task, group, /*isNewest*/false))
+			return true;
+	}
+
+	return false;
+}
+
+bool ThreadPool::popTaskFrom(WorkQueue& queue, Task& task, const TaskGroup* group, bool isNewest)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+		return false;
+
+	auto found = queue.tasks.end();
+	if (group == nullptr)
+	{
+		found = isNewest ? queue.tasks.end() - 1 : queue.tasks.begin();
+	}
+	else if (isNewest)
+	{
+		auto it = std::find_if(queue.tasks.rbegin(), queue.tasks.rend(), [group](const Task& queued)
+		{
+			return queued.group == group;
+		});
+		if (it != queue.tasks.rend())
+			found = it.base() - 1;
+	}
+	else
+	{
+		found = std::find_if(queue.tasks.begin(), queue.tasks.end(), [group](const Task& queued)
+		{
+			return queued.group == group;
+		});
+	}
+
+	if (found == queue.tasks.end())
+		return false;
+
+	task = std::move(*found);
+	queue.tasks.erase(found);
+	m_queuedTasks--;
+	return true;
+}
+
+void ThreadPool::execute(Task& task)
+{
+	task.func();
+	task.group->finishTask();
+}
+
+bool ThreadPool::runPendingTask(const TaskGroup* group)
+{
+	Task task;
+	if (popTask(task, group))
+	{
+		execute(task);
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+	t_pool = this;
+	t_queueIndex = index;
+
+	while (true)
+	{
+		if (runPendingTask())
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeUp.wait(lock, [this]()
+		{
+			return m_stop || m_queuedTasks > 0;
+		});
+
+		if (m_stop && m_queuedTasks == 0)
+			return;
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+class ThreadPool;
+
+// The engine wide pool used by parallel_for. Created on first use, lives until the program exits.
+ThreadPool& getThreadPool();
+// Sets the number of workers of the engine wide pool. Only has an effect before its first use.
+void setThreadPoolWorkerCount(int workerCount);
+
+// A set of tasks that can be waited on together. The thread that waits
+// executes the queued tasks of the group itself until the whole group is finished,
+// so groups can be nested without deadlocking the pool. It never takes the tasks
+// of other groups, so a caller waiting for a short job doesn't end up running
+// the long job of another thread. When the rest of its tasks are running on other
+// threads, the waiter sleeps until the last one finishes instead of spinning.
+class TaskGroup
+{
+public:
+	TaskGroup();
+	TaskGroup(ThreadPool& pool);
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	void operator=(const TaskGroup&) = delete;
+
+	void run(std::function<void()> func);
+	void wait();
+
+protected:
+	friend class ThreadPool;
+
+	// Called by the thread that executed one of the tasks.
+	void finishTask();
+
+	ThreadPool& m_pool;
+	std::atomic<int> m_pending;
+	// The last task goes to zero under the mutex, so a sleeping waiter can't miss it.
+	std::mutex m_mutex;
+	std::condition_variable m_finished;
+};
+
+// A persistent pool of worker threads. Every worker has its own deque of tasks:
+// a worker pops its own newest tasks first (for cache locality) and steals the oldest
+// tasks of the other workers when it runs out, which balances uneven workloads.
+class ThreadPool
+{
+public:
+	// With the default workerCount of -1 one worker is created per hardware thread,
+	// minus one for the thread that calls parallelFor and helps while waiting.
+	ThreadPool(int workerCount = -1);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	void operator=(const ThreadPool&) = delete;
+
+	int workerCount() const { return (int)m_workers.size(); }
+	// How many threads can execute tasks at the same time, including the waiting caller.
+	int concurrency() const { return workerCount() + 1; }
+
+	// Calls func(begin, end) for consecutive chunks of [start, end) of at most grainSize items.
+	// The range is split recursively, so idle workers can steal the big halves.
+	// grainSize 0 chooses a chunk size from the range and the thread count.
+	void parallelFor(int start, int end, int grainSize, const std::function<void(int, int)>& func);
+
+	int defaultGrainSize(int itemCount) const;
+
+protected:
+	friend class TaskGroup;
+
+	struct Task
+	{
+		std::function<void()> func;
+		TaskGroup* group = nullptr;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void push(Task&& task);
+	// Runs one queued task on the calling thread, only of the given group if there is one.
+	// Returns false if there was nothing to do.
+	bool runPendingTask(const TaskGroup* group = nullptr);
+	bool popTask(Task& task, const TaskGroup* group);
+	// Takes the newest or the oldest task of the group from the queue, or of any group for nullptr.
+	bool popTaskFrom(WorkQueue& queue, Task& task, const TaskGroup* group, bool isNewest);
+	void execute(Task& task);
+	void workerLoop(int index);
+	int queueIndexForThisThread() const;
+
+	void splitRange(TaskGroup& group, int begin, int end, int grainSize,
+		const std::function<void(int, int)>& func);
+
+	Array<std::thread> m_workers;
+	// One queue per worker, and the last one is shared by threads outside the pool.
+	std::deque<WorkQueue> m_queues;
+
+	std::atomic<int> m_queuedTasks;
+	std::atomic<bool> m_stop;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeUp;
+};
+
+} // end namespace rae
@@ -0,0 +1,129 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "rae/core/ThreadPool.hpp"
+#include "rae/core/Utils.hpp"
+
+using namespace rae;
+
+SCENARIO("ThreadPool unittest", "[rae][ThreadPool]")
+{
+	GIVEN( "a pool with three workers" )
+	{
+		ThreadPool pool(3);
+
+		REQUIRE(pool.workerCount() == 3);
+		REQUIRE(pool.concurrency() == 4);
+
+		WHEN( "parallelFor is run with different grain sizes" )
+		{
+			THEN( "every index is visited exactly once" )
+			{
+				const int itemCount = 10007;
+				for (int grainSize : { 0, 1, 7, 64, 100000 })
+				{
+					std::vector<int> visits(itemCount, 0);
+					std::atomic<bool> emptyChunk(false);
+					pool.parallelFor(0, itemCount, grainSize, [&](int begin, int end)
+					{
+						// Catch isn't thread safe, so only record the failure here.
+						if (begin >= end)
+							emptyChunk = true;
+						for (int i = begin; i < end; ++i)
+						{
+							visits[i]++;
+						}
+					});
+
+					bool allOnes = true;
+					for (int i = 0; i < itemCount; ++i)
+					{
+						if (visits[i] != 1)
+							allOnes = false;
+					}
+					REQUIRE(allOnes == true);
+					REQUIRE(emptyChunk == false);
+				}
+			}
+		}
+
+		WHEN( "parallelFor is nested inside TaskGroup tasks" )
+		{
+			THEN( "it doesn't deadlock and all work is done" )
+			{
+				std::atomic<int> sum(0);
+				TaskGroup group(pool);
+				for (int t = 0; t < 8; ++t)
+				{
+					group.run([&]()
+					{
+						pool.parallelFor(0, 1000, 10, [&](int begin, int end)
+						{
+							sum += end - begin;
+						});
+					});
+				}
+				group.wait();
+
+				REQUIRE(sum == 8000);
+			}
+		}
+	}
+
+	GIVEN( "a pool without workers" )
+	{
+		ThreadPool pool(0);
+
+		THEN( "the caller does all the work" )
+		{
+			int sum = 0;
+			pool.parallelFor(5, 105, 3, [&](int begin, int end)
+			{
+				sum += end - begin;
+			});
+			REQUIRE(sum == 100);
+		}
+
+		THEN( "a waiting thread only runs the tasks of its own group" )
+		{
+			// Both threads outside the pool push to the same shared queue, and the task of the
+			// other thread is the newest one there when this thread starts waiting.
+			std::thread::id ownTaskThread;
+			TaskGroup group(pool);
+			group.run([&]() { ownTaskThread = std::this_thread::get_id(); });
+
+			std::atomic<bool> isOtherQueued(false);
+			std::atomic<bool> isOtherWaiting(false);
+			std::thread::id otherTaskThread;
+			std::thread other([&]()
+			{
+				TaskGroup otherGroup(pool);
+				otherGroup.run([&]() { otherTaskThread = std::this_thread::get_id(); });
+				isOtherQueued = true;
+				while (isOtherWaiting == false)
+					std::this_thread::yield();
+				otherGroup.wait();
+			});
+
+			while (isOtherQueued == false)
+				std::this_thread::yield();
+
+			group.wait();
+			// CHECK, so that the other thread is joined even if these fail.
+			CHECK(ownTaskThread == std::this_thread::get_id());
+			CHECK(otherTaskThread == std::thread::id());
+
+			isOtherWaiting = true;
+			const std::thread::id otherThread = other.get_id();
+			other.join();
+			REQUIRE(otherTaskThread == otherThread);
+		}
+	}
+}
+
+#endif
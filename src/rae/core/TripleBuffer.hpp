@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+
+namespace rae
+{
+
+// Passes the latest version of a value from one writer thread to one reader thread without
+// locks. The writer fills the back slot and publishes it, the reader takes the latest published
+// slot as its front. The third slot in the middle is what lets both of them work all the time:
+// neither ever waits for the other, and the reader just skips the versions it was too slow to see.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() :
+		m_middle(1)
+	{
+	}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	void operator=(const TripleBuffer&) = delete;
+
+	// Writer thread only.
+	T& back() { return m_slots[m_back]; }
+	// Hands the back slot over to the reader, and takes the one it hasn't seen or has let go of.
+	void publish()
+	{
+		m_back = m_middle.exchange(m_back | NewBit, std::memory_order_acq_rel) & IndexMask;
+	}
+
+	// Reader thread only.
+	T& front() { return m_slots[m_front]; }
+	const T& front() const { return m_slots[m_front]; }
+	// Makes the latest published slot the front one. Returns false if nothing new was published.
+	bool update()
+	{
+		if ((m_middle.load(std::memory_order_acquire) & NewBit) == 0)
+			return false;
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+
+	// For initializing the slots before the threads start using them.
+	T& slot(int index) { return m_slots[index]; }
+
+protected:
+	static const int IndexMask = 3;
+	static const int NewBit = 4;
+
+	T m_slots[3];
+	int m_back = 0;
+	std::atomic<int> m_middle; // The index of the middle slot, and NewBit when the reader hasn't seen it.
+	int m_front = 2;
+};
+
+}
@@ -0,0 +1,85 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <thread>
+
+#include "rae/core/TripleBuffer.hpp"
+
+using namespace rae;
+
+SCENARIO("TripleBuffer unittest", "[rae][TripleBuffer]")
+{
+	GIVEN( "a triple buffer of counters" )
+	{
+		struct Counter
+		{
+			int value = 0;
+			int copy = 0; // Always the same as value, unless a slot is being written while read.
+		};
+		TripleBuffer<Counter> buffer;
+
+		THEN( "the reader only sees what has been published" )
+		{
+			REQUIRE(buffer.update() == false);
+
+			buffer.back().value = 1;
+			REQUIRE(buffer.update() == false);
+
+			buffer.publish();
+			REQUIRE(buffer.update() == true);
+			REQUIRE(buffer.front().value == 1);
+			REQUIRE(buffer.update() == false);
+			REQUIRE(buffer.front().value == 1);
+		}
+
+		THEN( "the reader skips to the latest of many publishes" )
+		{
+			for (int i = 1; i <= 5; ++i)
+			{
+				buffer.back().value = i;
+				buffer.publish();
+			}
+			REQUIRE(buffer.update() == true);
+			REQUIRE(buffer.front().value == 5);
+		}
+
+		THEN( "a reader and a writer on different threads never share a slot" )
+		{
+			const int count = 200000;
+			std::thread writer([&]()
+			{
+				for (int i = 1; i <= count; ++i)
+				{
+					buffer.back().value = i;
+					buffer.back().copy = i;
+					buffer.publish();
+				}
+			});
+
+			// Catch isn't thread safe, so only record the failures here.
+			bool isTorn = false;
+			bool isInOrder = true;
+			int last = 0;
+			while (last < count)
+			{
+				if (buffer.update())
+				{
+					const Counter& counter = buffer.front();
+					if (counter.value != counter.copy)
+						isTorn = true;
+					if (counter.value <= last)
+						isInOrder = false;
+					last = counter.value;
+				}
+			}
+			writer.join();
+
+			REQUIRE(isTorn == false);
+			REQUIRE(isInOrder == true);
+		}
+	}
+}
+
+#endif
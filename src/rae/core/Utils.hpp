@@ -4,11 +4,11 @@
 #include <math.h>
 #include <string>
 #include <algorithm>
-#include <thread>
 
 #include <glm/glm.hpp>
 
 #include "rae/core/Types.hpp"
+#include "rae/core/ThreadPool.hpp"
 
 namespace rae
 {
@@ -59,39 +59,24 @@ String toString(glm::vec3 position);
 
 }
 
-/* A simple parallel for loop.
+/* A simple parallel for loop, run on the engine ThreadPool.
 // Usage example:
 parallel_for(0, array.size(), [&](int i)
 {
 	array[i] = computeSomeResult();
 });
+// grainSize is the number of consecutive indices one task handles. The default 0 picks one
+// from the range size. Use a small grainSize when the cost per index varies a lot.
 */
 template<typename Callable>
-static void parallel_for(int start, int end, Callable func)
+static void parallel_for(int start, int end, Callable func, int grainSize = 0)
 {
-	const static int threadCountHint = (int)std::thread::hardware_concurrency();
-	const static int threadCount = (threadCountHint == 0 ? 8 : threadCountHint);
-
-	std::vector<std::thread> threads(threadCount);
-
-	for (int t = 0; t < threadCount; ++t)
+	getThreadPool().parallelFor(start, end, grainSize, [&func](int beginIndex, int endIndex)
 	{
-		threads[t] = std::thread(std::bind(
-		[&](const int beginIndex, const int endIndex, const int t)
+		for (int i = beginIndex; i < endIndex; ++i)
 		{
-			for (int i = beginIndex; i < endIndex; ++i)
-			{
-				func(i);
-			}
-		},
-		t * end / threadCount,
-		(t+1) == threadCount ? end : (t+1) * end / threadCount,
-		t));
-	}
-
-	std::for_each(threads.begin(),threads.end(), [](std::thread& x)
-	{
-		x.join();
+			func(i);
+		}
 	});
 }
 
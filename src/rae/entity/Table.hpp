@@ -206,6 +206,18 @@ public:
 		}
 	}
 
+	// For components that are changed in place, to tell the others the same as assign would.
+	void setUpdated(Id id)
+	{
+		if (check(id))
+			m_updated[m_idMap[id]] = true;
+	}
+
+	void setUpdatedF(Id id)
+	{
+		m_updated[m_idMap[id]] = true;
+	}
+
 	bool isUpdated(Id id) const
 	{
 		if (check(id))
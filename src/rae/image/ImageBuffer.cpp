@@ -111,6 +111,15 @@ void ImageBuffer::createImage(NVGcontext* vg)
 	}
 }
 
+void ImageBuffer::deleteImage(NVGcontext* vg)
+{
+	if (m_imageId != -1 && vg != nullptr)
+	{
+		nvgDeleteImage(vg, m_imageId);
+		m_imageId = -1;
+	}
+}
+
 void ImageBuffer::clear()
 {
 	std::fill(m_colorData.begin(), m_colorData.end(), vec3(0,0,0));
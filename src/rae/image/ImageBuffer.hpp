@@ -36,6 +36,8 @@ public:
 
 	// Create a NanoVG image
 	void createImage(NVGcontext* vg);
+	// Delete the NanoVG image, so that it can be created again after a resize.
+	void deleteImage(NVGcontext* vg);
 	void update8BitImageBuffer(NVGcontext* vg);
 	void clear();
 
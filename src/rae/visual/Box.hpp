@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cfloat>
+
 #include "rae/core/Types.hpp"
 #include "rae/visual/Transform.hpp"
 
@@ -14,7 +16,7 @@ class Box
 public:
 	Box() :
 		m_min(FLT_MAX, FLT_MAX, FLT_MAX),
-		m_max(FLT_MIN, FLT_MIN, FLT_MIN)
+		m_max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
 	{
 	}
 
@@ -27,10 +29,10 @@ public:
 	void clear()
 	{
 		m_min = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
-		m_max = vec3(FLT_MIN, FLT_MIN, FLT_MIN);
+		m_max = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 	}
 
-	bool valid()
+	bool valid() const
 	{
 		if (m_min.x <= m_max.x
 			&& m_min.y <= m_max.y
@@ -48,6 +50,19 @@ public:
 		return m_max - m_min;
 	}
 
+	vec3 center() const
+	{
+		return 0.5f * (m_min + m_max);
+	}
+
+	float surfaceArea() const
+	{
+		if (valid() == false)
+			return 0.0f;
+		vec3 d = dimensions();
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
 	void transform(const Transform& tr);
 
 	const vec3& min() const { return m_min; }
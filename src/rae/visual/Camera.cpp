@@ -5,17 +5,13 @@
 
 #include "rae/core/Random.hpp"
 #include "rae/visual/Camera.hpp"
+#include "rae_ray/Sampler.hpp"
 
 using namespace rae;
 
 vec3 rae::randomInUnitDisk()
 {
-	vec3 point;
-	do
-	{
-		point = 2.0f * vec3(getRandom(), getRandom(), 0) - vec3(1,1,0);
-	} while (glm::dot(point, point) >= 1.0f);
-	return point;
+	return sampleUnitDisk(vec2(getRandom(), getRandom()));
 }
 
 Camera::Camera()
@@ -38,11 +34,16 @@ Camera::Camera(float fieldOfViewRadians, float setAspectRatio, float aperture, f
 }
 
 Ray Camera::getRay(float s, float t) const
+{
+	return getRay(s, t, vec2(getRandom(), getRandom()));
+}
+
+Ray Camera::getRay(float s, float t, const vec2& lensSample) const
 {
 	//return Ray(origin, lowerLeftCorner + (s * m_horizontal) + (t * m_vertical) - origin);
 	// Normal:
 	//return Ray(m_position, m_topLeftCorner + (s * m_horizontal) - (t * m_vertical) - m_position);
-	vec3 rd = m_lensRadius * randomInUnitDisk();
+	vec3 rd = m_lensRadius * sampleUnitDisk(lensSample);
 	vec3 offset = m_right * rd.x + m_up * rd.y;
 	//return Ray(m_position + offset, m_lowerLeftCorner + (s * m_horizontal) + (t * m_vertical) - m_position - offset);
 	return Ray(m_position + offset, m_topLeftCorner + (s * m_horizontal) - (t * m_vertical) - m_position - offset);
@@ -56,6 +57,20 @@ Ray Camera::getExactRay(float s, float t) const
 	return Ray(m_position, m_topLeftCorner + (s * m_horizontal) - (t * m_vertical) - m_position);
 }
 
+bool Camera::project(const vec3& point, vec2& screen) const
+{
+	vec3 toPoint = point - m_position;
+	float forward = glm::dot(toPoint, m_direction);
+	if (forward <= 0.0f)
+		return false;
+
+	// Where the ray to the point crosses the image plane, relative to the top left corner.
+	vec3 onPlane = toPoint * (m_focusDistance / forward) - (m_topLeftCorner - m_position);
+	screen.x = glm::dot(onPlane, m_horizontal) / glm::dot(m_horizontal, m_horizontal);
+	screen.y = -glm::dot(onPlane, m_vertical) / glm::dot(m_vertical, m_vertical);
+	return true;
+}
+
 void Camera::calculateFrustum()
 {
 	m_lensRadius = m_aperture / 2.0f;
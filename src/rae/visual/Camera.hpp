@@ -25,7 +25,12 @@ public:
 	// s and t are from 0.0f to 1.0f, s being x, and t being y coordinate.
 	// Top left corner is 0.0f, 0.0f and center 0.5f, 0.5f.
 	Ray getRay(float s, float t) const;
+	// The point on the lens from a 2D sample in [0, 1).
+	Ray getRay(float s, float t, const vec2& lensSample) const;
 	Ray getExactRay(float s, float t) const;
+	// The inverse of getExactRay: where the point is seen on the screen, as s and t.
+	// Returns false for points behind the camera.
+	bool project(const vec3& point, vec2& screen) const;
 
 	void calculateFrustum();
 
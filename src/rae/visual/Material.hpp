@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include <glm/glm.hpp>
 
 #include "rae/core/Types.hpp"
@@ -13,6 +15,8 @@ struct NVGcontext;
 namespace rae
 {
 
+class Sampler;
+
 class Material
 {
 public:
@@ -27,10 +31,18 @@ public:
 	{
 	}
 
-	virtual bool scatter(const Ray& r_in, const HitRecord& record, vec3& attenuation, Ray& scattered) const;
+	virtual bool scatter(const Ray& r_in, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const;
 	virtual vec3 emitted(const vec3& p) const { return vec3(0.0f, 0.0f, 0.0f); }
+
+	// For light sampling. Diffuse materials can be evaluated for any direction, the others only
+	// scatter to directions of their own choosing, like mirrors do.
+	virtual bool isDiffuse() const { return false; }
+	// The light scattered from a normalized direction, cosine included, and the probability
+	// density of scatter() choosing that direction.
+	virtual vec3 evaluate(const HitRecord& record, const vec3& direction) const { return vec3(0.0f, 0.0f, 0.0f); }
+	virtual float scatterPdf(const HitRecord& record, const vec3& direction) const { return 0.0f; }
 	
-	bool metal(const Ray& r_in, const HitRecord& record, vec3& attenuation, Ray& scattered) const;
+	bool metal(const Ray& r_in, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const;
 
 	void generateFBO(NVGcontext* vg);
 	void update(NVGcontext* vg, double time);
@@ -44,7 +56,9 @@ public:
 	void animate(bool set) { m_animate = set; }
 
 protected:
-	FrameBufferImage m_frameBufferImage;
+	// Only for the materials shown in the editor. Created in generateFBO, as it takes megabytes
+	// and the ray tracer scenes have hundreds of materials.
+	std::unique_ptr<FrameBufferImage> m_frameBufferImage;
 
 	Color m_color;
 
@@ -61,7 +75,11 @@ public:
 		Material(albedo)
 	{}
 
-	bool scatter(const Ray& r_in, const HitRecord& record, vec3& attenuation, Ray& scattered) const override;
+	bool scatter(const Ray& r_in, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const override;
+
+	bool isDiffuse() const override { return true; }
+	vec3 evaluate(const HitRecord& record, const vec3& direction) const override;
+	float scatterPdf(const HitRecord& record, const vec3& direction) const override;
 };
 
 class Metal : public Material
@@ -72,7 +90,7 @@ public:
 		roughness(roughness)
 	{}
 
-	bool scatter(const Ray& r_in, const HitRecord& record, vec3& attenuation, Ray& scattered) const override;
+	bool scatter(const Ray& r_in, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const override;
 
 	float roughness = 0.0f;
 };
@@ -85,7 +103,7 @@ public:
 		refractiveIndex(refractiveIndex)
 	{}
 
-	bool scatter(const Ray& r_in, const HitRecord& record, vec3& attenuation, Ray& scattered) const override;
+	bool scatter(const Ray& r_in, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const override;
 
 	float refractiveIndex = 0.0f;
 };
@@ -98,7 +116,7 @@ public:
 	{
 	}
 
-	bool scatter(const Ray& r_in, const HitRecord& record, vec3& attenuation, Ray& scattered) const override { return false; }
+	bool scatter(const Ray& r_in, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const override { return false; }
 	Color3 emitted(const vec3& p) const override { return Color3(m_color); }
 };
 
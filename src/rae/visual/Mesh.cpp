@@ -6,6 +6,7 @@
 
 #include "loguru/loguru.hpp"
 #include "rae/visual/Material.hpp"
+#include "rae_ray/MaterialTable.hpp"
 
 using namespace rae;
 
@@ -31,7 +32,12 @@ Mesh::Mesh(Mesh&& other)
 	m_normals = std::move(other.m_normals);
 	m_indices = std::move(other.m_indices);
 	m_aabb = std::move(other.m_aabb);
+	m_triangleTree = std::move(other.m_triangleTree);
+	m_triangleSet = std::move(other.m_triangleSet);
+	m_triangleTreeValid = other.m_triangleTreeValid.load();
+	other.m_triangleTreeValid = false;
 	m_material = other.m_material;
+	m_materialIndex = other.m_materialIndex;
 
 	other.m_material = nullptr;
 
@@ -50,7 +56,12 @@ Mesh& Mesh::operator=(Mesh&& other)
 		m_normals = std::move(other.m_normals);
 		m_indices = std::move(other.m_indices);
 		m_aabb = std::move(other.m_aabb);
+		m_triangleTree = std::move(other.m_triangleTree);
+		m_triangleSet = std::move(other.m_triangleSet);
+		m_triangleTreeValid = other.m_triangleTreeValid.load();
+		other.m_triangleTreeValid = false;
 		m_material = other.m_material;
+		m_materialIndex = other.m_materialIndex;
 
 		other.m_material = nullptr;
 
@@ -63,6 +74,12 @@ void Mesh::createVBOs(GLenum usage)
 {
 	//LOG_F(INFO, "Mesh::createVBOs.");
 
+	if (glGenBuffers == nullptr)
+	{
+		// No OpenGL context yet, e.g. in the unit tests. The mesh can still be ray traced.
+		return;
+	}
+
 	if (m_vertices.size() <= 0 ||
 		m_indices.size() <= 0 ||
 		m_uvs.size() <= 0 ||
@@ -198,32 +215,109 @@ bool Mesh::rayTriangleIntersection(const vec3& rayStart, const vec3& rayDirectio
 
 bool Mesh::hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const
 {
+	RAE_COUNT_RAY_STAT(aabbTestCount, 1);
 	if (m_aabb.hit(ray, t_min, t_max) == false)
 		return false;
 
-	vec3 v0, v1, v2;
-	float u, v;
-	float hitDistance;
+	const BvhTree& tree = triangleTree();
 
-	bool isHit = false;
+	float closestDistance = t_max;
+	int hitTriangle = -1;
 
-	for (int i = 0; i < triangleCount(); ++i)
+	tree.traverseLeaves(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
 	{
-		getTriangle(i, v0, v1, v2);
+		RAE_COUNT_RAY_STAT(triangleTestCount, end - begin);
+		// Shrinks farT to keep the closest hit.
+		int triangle = m_triangleSet.intersect(ray, begin, end, nearT, farT);
+		if (triangle == -1)
+			return false;
+
+		closestDistance = farT;
+		hitTriangle = triangle;
+		return true;
+	});
+
+	if (hitTriangle == -1)
+		return false;
+
+	record.t = closestDistance;
+	record.point = ray.pointAtParameter(record.t);
+	record.normal = getFaceNormal(tree.primitiveIndices()[hitTriangle]); // currently just face normals
+	record.material = m_material;
+	record.materialIndex = m_materialIndex;
+	return true;
+}
+
+void Mesh::bindMaterials(MaterialTable& table)
+{
+	m_materialIndex = m_material ? table.add(*m_material) : -1;
+}
+
+bool Mesh::occluded(const Ray& ray, float t_min, float t_max) const
+{
+	RAE_COUNT_RAY_STAT(aabbTestCount, 1);
+	if (m_aabb.hit(ray, t_min, t_max) == false)
+		return false;
+
+	const BvhTree& tree = triangleTree();
+	return tree.traverseLeavesAny(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
+	{
+		RAE_COUNT_RAY_STAT(triangleTestCount, end - begin);
+		return m_triangleSet.intersect(ray, begin, end, nearT, farT) != -1;
+	});
+}
 
-		if (rayTriangleIntersection(ray.origin(), ray.direction(), v0, v1, v2, hitDistance, u, v)
-			&& hitDistance < t_max
-			&& hitDistance > t_min)
+const BvhTree& Mesh::triangleTree() const
+{
+	// On the first ray the other render threads wait for the lock, so there is nobody to help
+	// with the subtrees of a parallel build.
+	if (m_triangleTreeValid == false)
+		buildTriangleTree(/*allowParallel*/false);
+	return m_triangleTree;
+}
+
+void Mesh::buildTrees() const
+{
+	if (m_triangleTreeValid == false)
+		buildTriangleTree(/*allowParallel*/true);
+}
+
+void Mesh::buildTriangleTree(bool allowParallel) const
+{
+	// Many render threads can get here at once with the first rays, so only one of them builds.
+	std::lock_guard<std::mutex> lock(m_triangleTreeMutex);
+	if (m_triangleTreeValid == false)
+	{
+		Array<Box> aabbs;
+		aabbs.reserve(triangleCount());
+		vec3 v0, v1, v2;
+		for (int i = 0; i < triangleCount(); ++i)
 		{
-			isHit = true;
-			record.t = hitDistance;
-			record.point = ray.pointAtParameter(record.t);
-			record.normal = getFaceNormal(i); // currently just face normals
-			record.material = m_material;
+			getTriangle(i, v0, v1, v2);
+			Box aabb;
+			aabb.grow(v0);
+			aabb.grow(v1);
+			aabb.grow(v2);
+			aabbs.push_back(aabb);
 		}
-	}
 
-	return isHit;
+		BvhBuildOptions options;
+		// Leaves of up to two SIMD batches.
+		options.maxPrimitivesInLeaf = 2 * TriangleSet::BatchSize;
+		options.primitiveBatchSize = TriangleSet::BatchSize;
+		options.allowParallel = allowParallel;
+		m_triangleTree.build(aabbs, options);
+
+		m_triangleSet.clear();
+		m_triangleSet.reserve(triangleCount());
+		for (int triangle : m_triangleTree.primitiveIndices())
+		{
+			getTriangle(triangle, v0, v1, v2);
+			m_triangleSet.add(v0, v1, v2);
+		}
+
+		m_triangleTreeValid = true;
+	}
 }
 
 void Mesh::getTriangle(int idx, vec3& out0, vec3& out1, vec3& out2) const
@@ -257,6 +351,8 @@ vec3 Mesh::getFaceNormal(int idx) const
 
 void Mesh::computeAabb()
 {
+	invalidateTriangleTree();
+
 	m_aabb.clear();
 	for(int i = 0; i < (int)m_vertices.size(); ++i)
 	{
@@ -613,6 +709,8 @@ void Mesh::computeFaceNormals()
 
 void Mesh::generateLinesFromVertices(const Array<vec3>& vertices)
 {
+	invalidateTriangleTree();
+
 	m_vertices.clear();
 	m_uvs.clear();
 	m_normals.clear();
@@ -646,6 +744,17 @@ void Mesh::generateLinesFromVertices(const Array<vec3>& vertices)
 	}
 }
 
+void Mesh::copyGeometry(const Mesh& other)
+{
+	invalidateTriangleTree();
+
+	m_vertices = other.m_vertices;
+	m_uvs = other.m_uvs;
+	m_normals = other.m_normals;
+	m_indices = other.m_indices;
+	m_aabb = other.m_aabb;
+}
+
 //ASSIMP
 bool Mesh::loadModel(const String& filepath)
 {
@@ -683,6 +792,7 @@ bool Mesh::loadModel(const String& filepath)
 	}
 
 	loadNode(scene, scene->mRootNode);
+	invalidateTriangleTree();
 
 	// Aabb already computed inside loadNode because we need it for UV computation
 	//computeAabb();
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
@@ -14,6 +17,8 @@
 #include "rae/core/Types.hpp"
 
 #include "rae_ray/Hitable.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/TriangleSet.hpp"
 #include "rae/visual/Box.hpp"
 
 namespace rae
@@ -34,13 +39,18 @@ public:
 	void freeVBOs();
 
 	virtual bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const;
+	virtual bool occluded(const Ray& ray, float t_min, float t_max) const;
 	virtual Box getAabb(float t0 = 0.0f, float t1 = 0.0f) const { return m_aabb; }
+	void bindMaterials(MaterialTable& table) override;
+	void buildTrees() const override;
 
 	void generateBox();
 	void generateSphere(float radius = 0.5f, int rings = 32, int sectors = 32);
 	void generateCone(int steps = 12);
 
 	void generateLinesFromVertices(const Array<vec3>& vertices);
+	// The vertices, uvs, normals and indices, without the VBOs or the material.
+	void copyGeometry(const Mesh& other);
 
 	//ASSIMP
 	bool loadModel(const String& filepath);
@@ -53,6 +63,13 @@ public:
 	void computeAabb();
 	void computeFaceNormals();
 
+	// The Bvh over the triangles that hit() uses. Built on the first trace after the geometry changed,
+	// together with the triangleSet, which has the triangles in the order the leaves refer to them.
+	const BvhTree& triangleTree() const;
+	const TriangleSet& triangleSet() const { triangleTree(); return m_triangleSet; }
+	// Call after changing the geometry without the generate or load functions.
+	void invalidateTriangleTree() { m_triangleTreeValid = false; }
+
 protected:
 
 	bool rayTriangleIntersection(const vec3& rayStart, const vec3& rayDirection,
@@ -60,6 +77,7 @@ protected:
 		float& t, float& u, float& v/*, bool& frontFacing*/) const;
 	void getTriangle(int idx, vec3& out0, vec3& out1, vec3& out2) const;
 	vec3 getFaceNormal(int idx) const;
+	void buildTriangleTree(bool allowParallel) const;
 
 	Array<vec3> m_vertices;
 	Array<vec2> m_uvs;
@@ -72,7 +90,14 @@ protected:
 	GLuint m_indexBufferId	= 0;
 
 	Box m_aabb;
+
+	mutable BvhTree m_triangleTree;
+	mutable TriangleSet m_triangleSet;
+	mutable std::atomic<bool> m_triangleTreeValid{false};
+	mutable std::mutex m_triangleTreeMutex;
+
 	Material* m_material; // RAE_TODO make better, don't use pointer. Use component ID.
+	int m_materialIndex = -1; // Into the bound MaterialTable of the ray tracer.
 };
 
 } // end namespace rae
@@ -0,0 +1,107 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cfloat>
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/HitRecord.hpp"
+
+using namespace rae;
+
+// Gives access to the triangles, to compare against testing every one of them.
+class LinearHitMesh : public Mesh
+{
+public:
+	bool hitLinear(const Ray& ray, float t_min, float t_max, HitRecord& record) const
+	{
+		vec3 v0, v1, v2;
+		float u, v;
+		float hitDistance;
+		bool isHit = false;
+
+		for (int i = 0; i < triangleCount(); ++i)
+		{
+			getTriangle(i, v0, v1, v2);
+
+			if (rayTriangleIntersection(ray.origin(), ray.direction(), v0, v1, v2, hitDistance, u, v)
+				&& hitDistance < t_max
+				&& hitDistance > t_min)
+			{
+				isHit = true;
+				t_max = hitDistance;
+				record.t = hitDistance;
+			}
+		}
+		return isHit;
+	}
+};
+
+// Random rays from outside the mesh towards a point near the center.
+static Ray randomRayTowardsCenter(float distance)
+{
+	vec3 origin(getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f));
+	origin = glm::normalize(origin) * distance;
+	vec3 target(getRandom(-0.5f, 0.5f), getRandom(-0.5f, 0.5f), getRandom(-0.5f, 0.5f));
+	return Ray(origin, glm::normalize(target - origin));
+}
+
+SCENARIO("Mesh unittest", "[rae][Mesh]")
+{
+	GIVEN( "a generated sphere mesh" )
+	{
+		LinearHitMesh mesh;
+		mesh.generateSphere(1.0f, 24, 24);
+
+		THEN( "the triangle Bvh is built on the first trace and hits the same triangles as testing all of them, also as a shadow ray" )
+		{
+			int mismatches = 0;
+			int hits = 0;
+			for (int i = 0; i < 1000; ++i)
+			{
+				Ray ray = randomRayTowardsCenter(3.0f);
+				HitRecord treeRecord;
+				HitRecord linearRecord;
+				bool treeHit = mesh.hit(ray, 0.001f, FLT_MAX, treeRecord);
+				bool linearHit = mesh.hitLinear(ray, 0.001f, FLT_MAX, linearRecord);
+
+				if (treeHit != linearHit
+					|| (treeHit && treeRecord.t != linearRecord.t)
+					|| mesh.occluded(ray, 0.001f, FLT_MAX) != linearHit
+					|| (linearHit && mesh.occluded(ray, 0.001f, 0.99f * linearRecord.t)))
+				{
+					mismatches++;
+				}
+				if (treeHit)
+					hits++;
+			}
+
+			REQUIRE(mesh.triangleTree().primitiveCount() == mesh.triangleCount());
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+		}
+
+		WHEN( "the geometry is regenerated" )
+		{
+			Ray ray(vec3(0.0f, 0.0f, 5.0f), vec3(0.0f, 0.0f, -1.0f));
+			HitRecord record;
+			REQUIRE(mesh.hit(ray, 0.001f, FLT_MAX, record));
+			REQUIRE(record.t < 4.1f);
+
+			mesh.generateBox();
+
+			THEN( "the triangle Bvh is rebuilt" )
+			{
+				REQUIRE(mesh.triangleCount() == 12);
+				REQUIRE(mesh.hit(ray, 0.001f, FLT_MAX, record));
+				REQUIRE(record.t == Approx(4.5f));
+				REQUIRE(mesh.triangleTree().primitiveCount() == 12);
+			}
+		}
+	}
+}
+
+#endif
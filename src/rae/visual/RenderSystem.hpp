@@ -113,6 +113,8 @@ public:
 
 	void addMeshLink(Id id, Id linkId);
 	void addMaterialLink(Id id, Id linkId);
+	const Table<MeshLink>& meshLinks() const { return m_meshLinks; }
+	const Table<Id>& materialLinks() const { return m_materialLinks; }
 
 	const String& fpsString() const { return m_fpsString; }
 
@@ -15,7 +15,8 @@ public:
 	String toString() const;
 
 	void setTarget(glm::vec3 setTarget, float duration);
-	void update(double time);
+	// Returns true if the position changed.
+	bool update(double time);
 
 	vec3 position = vec3(0.0f, 0.0f, 0.0f);
 	qua rotation;
@@ -15,10 +15,11 @@ TransformSystem::TransformSystem(const Time& time) :
 
 UpdateStatus TransformSystem::update()
 {
-	for (auto&& transform : m_transforms.items())
+	query<Transform>(m_transforms, [&](Id id, Transform& transform)
 	{
-		transform.update(m_time.time());
-	}
+		if (transform.update(m_time.time()))
+			m_transforms.setUpdated(id);
+	});
 	return UpdateStatus::NotChanged;
 }
 
@@ -45,6 +46,7 @@ Transform& TransformSystem::getTransform(Id id)
 void TransformSystem::setPosition(Id id, const vec3& position)
 {
 	m_transforms.get(id).position = position;
+	m_transforms.setUpdated(id);
 }
 
 const vec3& TransformSystem::getPosition(Id id)
@@ -56,4 +58,5 @@ void TransformSystem::translate(Id id, vec3 delta)
 {
 	// Note: doesn't check if Id exists. Will crash/cause stuff if used unwisely.
 	m_transforms.getF(id).position += delta; 
+	m_transforms.setUpdatedF(id);
 }
@@ -35,6 +35,9 @@ public:
 
 	void translate(Id id, vec3 delta);
 
+	// Updated when added or moved during the frame.
+	const Table<Transform>& transforms() const { return m_transforms; }
+
 private:
 	const Time& m_time;
 
@@ -0,0 +1,880 @@
+#include "MicroBenchmarks.hpp"
+
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "loguru/loguru.hpp"
+
+#include "rae/core/Random.hpp"
+#include "rae/core/Simd.hpp"
+#include "rae/core/ThreadPool.hpp"
+#include "rae/core/Utils.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/Denoiser.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Instance.hpp"
+#include "rae_ray/MaterialTable.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/ReferenceRender.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/Scenes.hpp"
+#include "rae_ray/Sphere.hpp"
+#include "rae_ray/SphereSet.hpp"
+#include "rae_ray/TileScheduler.hpp"
+#include "rae_ray/TriangleSet.hpp"
+
+using namespace rae;
+
+// Best of a few runs, to keep the noise from other processes out.
+template<typename Func>
+static double raysPerSecond(int rayCount, int runs, Func func)
+{
+	double bestSeconds = DBL_MAX;
+	for (int run = 0; run < runs; ++run)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(end - start).count());
+	}
+	return double(rayCount) / bestSeconds;
+}
+
+template<typename HitableType>
+static double raysPerSecond(const HitableType& hitable, const Array<Ray>& rays)
+{
+	return raysPerSecond((int)rays.size(), /*runs*/3, [&]()
+	{
+		for (auto&& ray : rays)
+		{
+			HitRecord record;
+			hitable.hit(ray, 0.001f, FLT_MAX, record);
+		}
+	});
+}
+
+static vec3 randomPoint(float extent)
+{
+	return vec3(getRandom(-extent, extent), getRandom(-extent, extent), getRandom(-extent, extent));
+}
+
+// A ground sphere and a grid of small spheres like in the book scene, but without materials,
+// which the Bvh doesn't need.
+static void createSphereGrid(HitableList& world, int gridSize)
+{
+	world.add(new Sphere(vec3(0, -1000, 0), 1000, nullptr));
+
+	for (int a = -gridSize; a < gridSize; a++)
+	{
+		for (int b = -gridSize; b < gridSize; b++)
+		{
+			vec3 center(a + 0.9f * getRandom(), 0.2f, b + 0.9f * getRandom());
+			world.add(new Sphere(center, 0.2f, nullptr));
+		}
+	}
+}
+
+// The previous parallel_for, which created and joined hardwareConcurrency threads per call
+// and split the range statically. Kept here as the baseline of the thread pool.
+template<typename Callable>
+static void spawnThreadsParallelFor(int start, int end, Callable func)
+{
+	const static int threadCountHint = (int)std::thread::hardware_concurrency();
+	const static int threadCount = (threadCountHint == 0 ? 8 : threadCountHint);
+
+	std::vector<std::thread> threads(threadCount);
+
+	for (int t = 0; t < threadCount; ++t)
+	{
+		const int beginIndex = start + t * (end - start) / threadCount;
+		const int endIndex = (t+1) == threadCount ? end : start + (t+1) * (end - start) / threadCount;
+		threads[t] = std::thread([&func, beginIndex, endIndex]()
+		{
+			for (int i = beginIndex; i < endIndex; ++i)
+			{
+				func(i);
+			}
+		});
+	}
+
+	for (auto&& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+template<typename Func>
+static double measureSeconds(int repeats, Func func)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < repeats; ++i)
+	{
+		func();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+static void benchmarkThreadPool()
+{
+	// A small 300x150 buffer, like the small ray tracer buffer.
+	{
+		const int width = 300;
+		const int height = 150;
+		std::vector<float> buffer(width * height, 0.5f);
+		const int repeats = 200;
+
+		auto gammaRow = [&](int y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				float& value = buffer[y * width + x];
+				value = std::pow(value, 1.0f / 2.2f);
+			}
+		};
+
+		double spawnTime = measureSeconds(repeats, [&]() { spawnThreadsParallelFor(0, height, gammaRow); });
+		double poolTime = measureSeconds(repeats, [&]() { parallel_for(0, height, gammaRow); });
+
+		LOG_F(INFO, "Small buffer, %i passes: spawn threads: %f ms/pass, thread pool: %f ms/pass, speedup: %fx",
+			repeats, 1000.0 * spawnTime / repeats, 1000.0 * poolTime / repeats, spawnTime / poolTime);
+	}
+
+	// An uneven workload where a few rows cost much more than the rest.
+	{
+		const int height = 1080;
+		std::vector<double> results(height, 0.0);
+		const int repeats = 10;
+
+		// The middle rows are expensive, like the rows that hit the glass ball.
+		auto unevenRow = [&](int y)
+		{
+			const int iterations = (y > height / 3 && y < height / 2) ? 40000 : 1000;
+			double value = 0.0;
+			for (int i = 0; i < iterations; ++i)
+			{
+				value += std::sqrt(double(i + y));
+			}
+			results[y] = value;
+		};
+
+		double spawnTime = measureSeconds(repeats, [&]() { spawnThreadsParallelFor(0, height, unevenRow); });
+		double poolTime = measureSeconds(repeats, [&]() { parallel_for(0, height, unevenRow, /*grainSize*/1); });
+
+		LOG_F(INFO, "Uneven rows, %i passes: spawn threads: %f ms/pass, thread pool: %f ms/pass, speedup: %fx",
+			repeats, 1000.0 * spawnTime / repeats, 1000.0 * poolTime / repeats, spawnTime / poolTime);
+	}
+}
+
+// A sphere mesh with a bunny-like triangle count, through its Bvh and every triangle one by one.
+static void benchmarkMesh()
+{
+	Mesh mesh;
+	mesh.generateSphere(1.0f, 180, 180);
+
+	const int rayCount = 2000;
+	Array<Ray> rays;
+	for (int i = 0; i < rayCount; ++i)
+	{
+		// From outside the mesh towards a point near the center.
+		vec3 origin = glm::normalize(randomPoint(1.0f)) * 3.0f;
+		rays.push_back(Ray(origin, glm::normalize(randomPoint(0.5f) - origin)));
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	mesh.triangleTree();
+	auto built = std::chrono::high_resolution_clock::now();
+	for (auto&& ray : rays)
+	{
+		HitRecord record;
+		mesh.hit(ray, 0.001f, FLT_MAX, record);
+	}
+	auto traced = std::chrono::high_resolution_clock::now();
+	const TriangleSet& triangles = mesh.triangleSet();
+	for (auto&& ray : rays)
+	{
+		float distance = FLT_MAX;
+		triangles.intersectScalar(ray, 0, triangles.size(), 0.001f, distance);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	double buildMs = std::chrono::duration<double, std::milli>(built - start).count();
+	double treeRate = rayCount / std::chrono::duration<double>(traced - built).count();
+	double linearRate = rayCount / std::chrono::duration<double>(end - traced).count();
+
+	LOG_F(INFO, "Mesh with %i triangles: Bvh build %f ms. Rays/s: linear: %f, Bvh: %f, speedup: %fx",
+		mesh.triangleCount(), buildMs, linearRate, treeRate, treeRate / linearRate);
+}
+
+template <typename HitableType>
+static double primaryRaysPerSecond(const HitableType& hitable, Camera& camera, int width, int height)
+{
+	camera.calculateFrustum();
+
+	int hits = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			Ray ray = camera.getExactRay(float(x) / float(width), float(y) / float(height));
+			HitRecord record;
+			if (hitable.hit(ray, 0.001f, FLT_MAX, record))
+				hits++;
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	return double(width * height) / seconds;
+}
+
+static void benchmarkScene(const char* name, HitableList& world, Camera& camera)
+{
+	const int width = 500;
+	const int height = 250;
+
+	double listRate = primaryRaysPerSecond(world, camera, width, height);
+	LOG_F(INFO, "%s: %i objects. Primary rays/s: list: %f", name, (int)world.list().size(), listRate);
+
+	for (auto splitMethod : { BvhSplitMethod::Median, BvhSplitMethod::Sah })
+	{
+		Bvh tree(world.list(), splitMethod);
+		const BvhStats& stats = tree.stats();
+		double treeRate = primaryRaysPerSecond(tree, camera, width, height);
+
+		LOG_F(INFO, "  %s: build %f ms, %i nodes, depth %i, leaf size avg %f max %i, SAH cost %f. Primary rays/s: %f, speedup: %fx",
+			splitMethod == BvhSplitMethod::Sah ? "Sah" : "Median",
+			stats.buildTimeMs, stats.nodeCount, stats.maxDepth, stats.averageLeafSize, stats.maxLeafSize,
+			stats.sahCost, treeRate, treeRate / listRate);
+	}
+}
+
+// Scenes 1 to 4 and a big grid of spheres, with both split methods.
+static void benchmarkBvh()
+{
+	{
+		HitableList world;
+		Camera camera;
+		createSceneOne(world, camera, /*loadBunny*/false);
+		benchmarkScene("Scene 1", world, camera);
+	}
+	{
+		HitableList world;
+		Camera camera;
+		createSceneOne(world, camera, /*loadBunny*/true);
+		benchmarkScene("Scene 2 (bunny)", world, camera);
+	}
+	{
+		HitableList world;
+		Camera camera;
+		createSceneFromBook(world, camera);
+		benchmarkScene("Scene 3 (book)", world, camera);
+	}
+	{
+		HitableList world;
+		Camera camera;
+		createSceneInstances(world, camera, /*loadBunny*/true);
+		benchmarkScene("Scene 4 (bunny instances)", world, camera);
+	}
+	{
+		HitableList world;
+		Camera camera;
+		createSceneFromBook(world, camera); // Just for the camera.
+		world.clear();
+		createSphereGrid(world, /*gridSize*/150);
+		benchmarkScene("Sphere grid 300x300", world, camera);
+	}
+}
+
+// A big grid of spheres that move a little every frame. A refit should cost a fraction of a rebuild.
+static void benchmarkBvhRefit()
+{
+	HitableList world;
+	createSphereGrid(world, /*gridSize*/150);
+	Bvh tree(world.list());
+	const double buildTimeMs = tree.stats().buildTimeMs;
+
+	const int frames = 20;
+	double refitTimeMs = 0.0;
+	int rebuilds = 0;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (int i = 1; i < (int)world.list().size(); ++i)
+		{
+			static_cast<Sphere*>(world.list()[i])->center += vec3(getRandom(-0.05f, 0.05f), 0.0f, getRandom(-0.05f, 0.05f));
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+		if (tree.update())
+			rebuilds++;
+		refitTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	LOG_F(INFO, "%i spheres: build %f ms, update %f ms per frame (refit only %f ms), %i rebuilds in %i frames. SAH cost %f, built %f",
+		(int)world.list().size(), buildTimeMs, refitTimeMs / frames, tree.stats().refitTimeMs, rebuilds, frames,
+		tree.stats().sahCost, tree.tree().builtSahCost());
+}
+
+// Traces the mesh through its triangle Bvh with the scalar kernel, to compare against Mesh::hit.
+static bool hitScalar(const Mesh& mesh, const Ray& ray, float t_min, float t_max)
+{
+	const TriangleSet& triangles = mesh.triangleSet();
+	return mesh.triangleTree().traverseLeaves(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
+	{
+		return triangles.intersectScalar(ray, begin, end, nearT, farT) != -1;
+	});
+}
+
+// The scalar and SIMD triangle kernels on the bunny, on their own and through the Bvh.
+static void benchmarkTriangleSet()
+{
+	Mesh mesh;
+	if (mesh.loadModel("./data/models/bunny.obj") == false)
+	{
+		LOG_F(ERROR, "Couldn't load the bunny, using a sphere with a similar triangle count.");
+		mesh.generateSphere(1.0f, 180, 180);
+	}
+
+	const Box aabb = mesh.getAabb();
+	const float radius = glm::length(aabb.dimensions());
+	Array<Ray> rays;
+	for (int i = 0; i < 20000; ++i)
+	{
+		vec3 origin = aabb.center() + glm::normalize(randomPoint(1.0f)) * radius;
+		vec3 target = aabb.center() + randomPoint(0.25f) * aabb.dimensions();
+		rays.push_back(Ray(origin, glm::normalize(target - origin)));
+	}
+
+	const TriangleSet& triangles = mesh.triangleSet();
+	const int rayCount = (int)rays.size();
+
+	// Every ray against every triangle, to see the kernels on their own.
+	const int bruteForceRays = 50;
+	double scalarRate = raysPerSecond(bruteForceRays, /*runs*/5, [&]()
+	{
+		for (int i = 0; i < bruteForceRays; ++i)
+		{
+			float distance = FLT_MAX;
+			triangles.intersectScalar(rays[i], 0, triangles.size(), 0.001f, distance);
+		}
+	});
+	double simdRate = raysPerSecond(bruteForceRays, /*runs*/5, [&]()
+	{
+		for (int i = 0; i < bruteForceRays; ++i)
+		{
+			float distance = FLT_MAX;
+			triangles.intersect(rays[i], 0, triangles.size(), 0.001f, distance);
+		}
+	});
+	LOG_F(INFO, "%i triangles, all of them per ray: scalar: %f rays/s, %s: %f rays/s, speedup: %fx",
+		triangles.size(), scalarRate, SimdName, simdRate, simdRate / scalarRate);
+
+	// Through the Bvh, like the ray tracer does.
+	double treeScalarRate = raysPerSecond(rayCount, /*runs*/5, [&]()
+	{
+		for (auto&& ray : rays)
+		{
+			hitScalar(mesh, ray, 0.001f, FLT_MAX);
+		}
+	});
+	double treeSimdRate = raysPerSecond(rayCount, /*runs*/5, [&]()
+	{
+		for (auto&& ray : rays)
+		{
+			HitRecord record;
+			mesh.hit(ray, 0.001f, FLT_MAX, record);
+		}
+	});
+	const BvhStats& stats = mesh.triangleTree().stats();
+	LOG_F(INFO, "Bvh with %i nodes, average leaf size %f: scalar: %f rays/s, %s: %f rays/s, speedup: %fx",
+		stats.nodeCount, stats.averageLeafSize, treeScalarRate, SimdName, treeSimdRate, treeSimdRate / treeScalarRate);
+}
+
+// The spheres of the book scene as a Bvh of Spheres and as a SphereSet, with the primary rays
+// of the book scene camera and random secondary rays from the spheres.
+static void benchmarkSphereSet()
+{
+	HitableList world;
+	SphereSet spheres;
+	world.add(new Sphere(vec3(0, -1000, 0), 1000, nullptr));
+	spheres.add(vec3(0, -1000, 0), 1000, nullptr);
+	const int gridSize = 11;
+	for (int a = -gridSize; a < gridSize; a++)
+	{
+		for (int b = -gridSize; b < gridSize; b++)
+		{
+			vec3 center(a + 0.9f * getRandom(), 0.2f, b + 0.9f * getRandom());
+			float radius = getRandom(0.1f, 0.45f);
+			world.add(new Sphere(center, radius, nullptr));
+			spheres.add(center, radius, nullptr);
+		}
+	}
+	spheres.build();
+	Bvh tree(world.list());
+
+	Camera camera;
+	{
+		HitableList bookScene;
+		createSceneFromBook(bookScene, camera); // Just for the camera.
+	}
+	camera.calculateFrustum();
+
+	const int width = 500;
+	const int height = 250;
+	Array<Ray> primaryRays;
+	Array<Ray> secondaryRays;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			Ray ray = camera.getRay(float(x) / float(width), float(y) / float(height));
+			primaryRays.push_back(ray);
+
+			// Bounce off in a random direction, like a diffuse surface would.
+			HitRecord record;
+			if (spheres.hit(ray, 0.001f, FLT_MAX, record))
+			{
+				vec3 direction = record.normal + vec3(getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f));
+				secondaryRays.push_back(Ray(record.point, direction));
+			}
+		}
+	}
+
+	double treePrimary = raysPerSecond(tree, primaryRays);
+	double setPrimary = raysPerSecond(spheres, primaryRays);
+	double treeSecondary = raysPerSecond(tree, secondaryRays);
+	double setSecondary = raysPerSecond(spheres, secondaryRays);
+
+	LOG_F(INFO, "%i spheres. Primary rays/s: Bvh of Spheres: %f, %s SphereSet: %f, speedup: %fx",
+		spheres.size(), treePrimary, SimdName, setPrimary, setPrimary / treePrimary);
+	LOG_F(INFO, "Secondary rays/s: Bvh of Spheres: %f, %s SphereSet: %f, speedup: %fx",
+		treeSecondary, SimdName, setSecondary, setSecondary / treeSecondary);
+}
+
+// Moving one of a hundred thousand instances of one box mesh and rebuilding the top level.
+static void benchmarkInstance()
+{
+	auto box = std::make_shared<Mesh>();
+	box->generateBox();
+
+	HitableList world;
+	Array<Instance*> instances;
+	for (int a = 0; a < 400; ++a)
+	{
+		for (int b = 0; b < 250; ++b)
+		{
+			instances.push_back(new Instance(box, glm::translate(mat4(1.0f), vec3(2.0f * a, 0.0f, 2.0f * b))));
+			world.add(instances.back());
+		}
+	}
+
+	for (int count : { 1000, 10000, 100000 })
+	{
+		const Array<Hitable*> hitables(world.list().begin(), world.list().begin() + count);
+		Bvh tree;
+		double totalMs = 0.0;
+		const int rounds = 10;
+		for (int round = 0; round < rounds; ++round)
+		{
+			auto start = std::chrono::steady_clock::now();
+			instances[round]->setTransform(glm::translate(mat4(1.0f), vec3(1.0f, float(round), 1.0f)));
+			tree.build(hitables);
+			totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+		LOG_F(INFO, "%i instances: top level rebuilt in %f ms, %i nodes", count, totalMs / rounds, tree.nodeCount());
+	}
+}
+
+// Creating a hundred thousand spheres with one new each and in the arena of the HitableList.
+static void benchmarkSceneArena()
+{
+	const int count = 100000;
+	Array<vec3> centers;
+	for (int i = 0; i < count; ++i)
+	{
+		centers.push_back(vec3(getRandom(-100.0f, 100.0f), 0.2f, getRandom(-100.0f, 100.0f)));
+	}
+
+	HitableList heapWorld;
+	HitableList arenaWorld;
+	double heapMs = 0.0;
+	double arenaMs = 0.0;
+	const int rounds = 10;
+	for (int round = 0; round < rounds; ++round)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		heapWorld.clear();
+		for (const vec3& center : centers)
+		{
+			heapWorld.add(new Sphere(center, 0.2f, nullptr));
+		}
+		auto middle = std::chrono::high_resolution_clock::now();
+		arenaWorld.clear();
+		for (const vec3& center : centers)
+		{
+			arenaWorld.create<Sphere>(center, 0.2f, nullptr);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		heapMs += std::chrono::duration<double, std::milli>(middle - start).count();
+		arenaMs += std::chrono::duration<double, std::milli>(end - middle).count();
+	}
+
+	Bvh tree(arenaWorld.list());
+	LOG_F(INFO, "%i spheres: clear and create with new %f ms, in the arena %f ms. Bvh build %f ms.",
+		count, heapMs / rounds, arenaMs / rounds, tree.stats().buildTimeMs);
+}
+
+// The book scene shaded from the material table and with the virtual materials.
+static void benchmarkMaterialTable()
+{
+	HitableList world;
+	Camera camera;
+	createSceneFromBook(world, camera);
+	camera.calculateFrustum();
+
+	Bvh tree(world.list());
+	MaterialTable table;
+	table.bind(world.list());
+
+	PathTracer pathTracer;
+	pathTracer.setWorld(&tree);
+	pathTracer.findLights(world.list());
+
+	const int width = 200;
+	const int height = 100;
+	const int sampleCount = 4;
+	AccumulationBuffer buffer;
+	buffer.init(width, height);
+	const MaterialTable* tables[] = { nullptr, &table };
+	for (const MaterialTable* materials : tables)
+	{
+		pathTracer.setMaterials(materials);
+		buffer.clear();
+		auto start = std::chrono::high_resolution_clock::now();
+		accumulateSamples(pathTracer, camera, buffer, sampleCount);
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		LOG_F(INFO, "%s: %f Msamples/s", materials ? "Material table" : "Virtual materials",
+			double(width * height * sampleCount) / seconds / 1.0e6);
+	}
+}
+
+// The error of every sampler type against a reference render of scene one.
+static void benchmarkSampler()
+{
+	HitableList world;
+	Camera camera;
+	createSceneOne(world, camera);
+	camera.calculateFrustum();
+	Bvh tree(world.list());
+
+	PathTracer pathTracer;
+	pathTracer.setWorld(&tree);
+
+	const int width = 96;
+	const int height = 54;
+	const int referenceSamples = 8192;
+
+	AccumulationBuffer buffer;
+	buffer.init(width, height);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	accumulateSamples(pathTracer, camera, buffer, referenceSamples, SamplerType::Random);
+	const Array<vec3> reference = bufferColors(buffer);
+	auto end = std::chrono::high_resolution_clock::now();
+	LOG_F(INFO, "Reference with %i samples per pixel in %f s", referenceSamples,
+		std::chrono::duration<double>(end - start).count());
+
+	for (int type = 0; type < int(SamplerType::Count); ++type)
+	{
+		String line;
+		for (int sampleCount = 1; sampleCount <= 64; sampleCount *= 2)
+		{
+			buffer.clear();
+			accumulateSamples(pathTracer, camera, buffer, sampleCount, SamplerType(type));
+			line += " " + std::to_string(sampleCount) + ": " + std::to_string(rootMeanSquareError(bufferColors(buffer), reference));
+		}
+		LOG_F(INFO, "%s RMSE per samples:%s", toString(SamplerType(type)).c_str(), line.c_str());
+	}
+}
+
+struct RenderResult
+{
+	Array<vec3> image;
+	double seconds = 0.0;
+	double averageBounces = 0.0;
+};
+
+static RenderResult render(const PathTracer& pathTracer, const Camera& camera, int width, int height, int sampleCount)
+{
+	AccumulationBuffer buffer;
+	buffer.init(width, height);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	const int64_t bounceCount = accumulateSamples(pathTracer, camera, buffer, sampleCount);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	RenderResult result;
+	result.image = bufferColors(buffer);
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	result.averageBounces = double(bounceCount) / (double(width) * height * sampleCount);
+	return result;
+}
+
+// Scene one, lit by two small lights, with and without sampling the lights directly.
+static void benchmarkLightSampling()
+{
+	HitableList world;
+	Camera camera;
+	createSceneOne(world, camera);
+	camera.calculateFrustum();
+	Bvh tree(world.list());
+
+	PathTracer pathTracer;
+	pathTracer.setWorld(&tree);
+	pathTracer.findLights(world.list());
+
+	const int width = 96;
+	const int height = 54;
+
+	pathTracer.setLightSampling(false);
+	RenderResult reference = render(pathTracer, camera, width, height, 8192);
+
+	for (bool isLightSampling : { false, true })
+	{
+		pathTracer.setLightSampling(isLightSampling);
+		String line;
+		for (int sampleCount : { 4, 16, 64 })
+		{
+			RenderResult result = render(pathTracer, camera, width, height, sampleCount);
+			line += " " + std::to_string(sampleCount) + ": " + std::to_string(rootMeanSquareError(result.image, reference.image))
+				+ " (" + std::to_string(1000000.0 * result.seconds / (double(width) * height * sampleCount)) + " us per sample)";
+		}
+		vec3 mean = average(render(pathTracer, camera, width, height, 256).image);
+		LOG_F(INFO, "Light sampling %s, RMSE per samples:%s, average color at 256 spp: %f %f %f",
+			isLightSampling ? "on" : "off", line.c_str(), mean.r, mean.g, mean.b);
+	}
+	vec3 mean = average(reference.image);
+	LOG_F(INFO, "Reference average color: %f %f %f", mean.r, mean.g, mean.b);
+}
+
+// The book scene with a high bounces limit, with and without Russian roulette.
+static void benchmarkRussianRoulette()
+{
+	HitableList world;
+	Camera camera;
+	createSceneFromBook(world, camera);
+	camera.calculateFrustum();
+	Bvh tree(world.list());
+
+	PathTracer pathTracer;
+	pathTracer.setWorld(&tree);
+	pathTracer.setBouncesLimit(500);
+
+	const int width = 96;
+	const int height = 54;
+
+	pathTracer.setRussianRoulette(false);
+	RenderResult reference = render(pathTracer, camera, width, height, 2048);
+
+	for (bool isRussianRoulette : { false, true })
+	{
+		pathTracer.setRussianRoulette(isRussianRoulette);
+		RenderResult result = render(pathTracer, camera, width, height, 64);
+		vec3 mean = average(result.image);
+		LOG_F(INFO, "Russian roulette %s: %f us per sample, average bounces: %f, RMSE at 64 spp: %f, average color: %f %f %f",
+			isRussianRoulette ? "on" : "off",
+			1000000.0 * result.seconds / (double(width) * height * 64),
+			result.averageBounces, rootMeanSquareError(result.image, reference.image),
+			mean.r, mean.g, mean.b);
+	}
+	vec3 mean = average(reference.image);
+	LOG_F(INFO, "Reference average color: %f %f %f", mean.r, mean.g, mean.b);
+}
+
+// Scene one at a few samples per pixel, noisy and denoised against a reference.
+static void benchmarkDenoiser()
+{
+	HitableList world;
+	Camera camera;
+	createSceneOne(world, camera);
+	camera.calculateFrustum();
+	Bvh tree(world.list());
+
+	PathTracer pathTracer;
+	pathTracer.setWorld(&tree);
+	pathTracer.findLights(world.list());
+
+	const int width = 192;
+	const int height = 108;
+	AccumulationBuffer buffer;
+	buffer.init(width, height);
+
+	accumulateSamples(pathTracer, camera, buffer, 4096);
+	const Array<vec3> reference = bufferColors(buffer);
+
+	Denoiser denoiser;
+	Array<vec3> denoised;
+	for (int sampleCount : { 4, 8, 16, 64 })
+	{
+		buffer.clear();
+		accumulateSamples(pathTracer, camera, buffer, sampleCount);
+		denoiser.denoise(buffer, denoised);
+		// Only the range that can be shown. Otherwise the error is all at the edges of the lights.
+		LOG_F(INFO, "%i spp: RMSE noisy: %f, denoised: %f, denoise time: %f ms", sampleCount,
+			rootMeanSquareError(bufferColors(buffer), reference, /*maxValue*/1.0f),
+			rootMeanSquareError(denoised, reference, /*maxValue*/1.0f),
+			denoiser.lastTimeMs());
+	}
+
+	// Time a full HD frame.
+	buffer.init(1920, 1080);
+	accumulateSamples(pathTracer, camera, buffer, 1);
+	denoiser.denoise(buffer, denoised);
+	LOG_F(INFO, "1920x1080 denoise time: %f ms", denoiser.lastTimeMs());
+}
+
+// The first pass of scene one at 1920x1080 in tiles and row by row.
+static void benchmarkTileScheduler()
+{
+	HitableList world;
+	Camera camera;
+	createSceneOne(world, camera);
+	camera.calculateFrustum();
+	Bvh tree(world.list());
+
+	PathTracer pathTracer;
+	pathTracer.setWorld(&tree);
+	pathTracer.findLights(world.list());
+
+	const int width = 1920;
+	const int height = 1080;
+
+	auto renderPixel = [&](Sampler& sampler, int x, int y)
+	{
+		return pathTracer.renderPixelSample(camera, sampler, x, y, width, height, /*sampleIndex*/0);
+	};
+
+	// The whole frame row by row, like before: nothing can be shown until it's all done.
+	auto start = std::chrono::steady_clock::now();
+	parallel_for(0, height, [&](int y)
+	{
+		SobolSampler sampler;
+		for (int x = 0; x < width; ++x)
+		{
+			renderPixel(sampler, x, y);
+		}
+	}, /*grainSize*/1);
+	const double rowsSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// The first pass center out, the second one with the costs of the first.
+	TileScheduler scheduler;
+	scheduler.init(width, height);
+	for (TileOrder order : { TileOrder::CenterOut, TileOrder::CostliestFirst })
+	{
+		double firstTileSeconds = 0.0;
+		std::atomic<bool> isFirstTile(true);
+		start = std::chrono::steady_clock::now();
+		scheduler.run(order, [&](int tileIndex)
+		{
+			const Tile& tile = scheduler.tile(tileIndex);
+			SobolSampler sampler;
+			for (int y = tile.y; y < tile.y + tile.height; ++y)
+			{
+				for (int x = tile.x; x < tile.x + tile.width; ++x)
+				{
+					renderPixel(sampler, x, y);
+				}
+			}
+			if (isFirstTile.exchange(false))
+				firstTileSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		});
+		const double tilesSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		LOG_F(INFO, "%s tiles on %i threads: first tile shown after %f ms, pass %f ms. Row by row: nothing shown until %f ms.",
+			order == TileOrder::CenterOut ? "Center out" : "Costliest first", getThreadPool().concurrency(),
+			1000.0 * firstTileSeconds, 1000.0 * tilesSeconds, 1000.0 * rowsSeconds);
+	}
+}
+
+struct MicroBenchmark
+{
+	const char* name;
+	void (*run)();
+};
+
+static const MicroBenchmark MicroBenchmarks[] =
+{
+	{ "threadpool", benchmarkThreadPool },
+	{ "mesh", benchmarkMesh },
+	{ "bvh", benchmarkBvh },
+	{ "bvhrefit", benchmarkBvhRefit },
+	{ "triangleset", benchmarkTriangleSet },
+	{ "sphereset", benchmarkSphereSet },
+	{ "instance", benchmarkInstance },
+	{ "scenearena", benchmarkSceneArena },
+	{ "materialtable", benchmarkMaterialTable },
+	{ "sampler", benchmarkSampler },
+	{ "lightsampling", benchmarkLightSampling },
+	{ "russianroulette", benchmarkRussianRoulette },
+	{ "denoiser", benchmarkDenoiser },
+	{ "tilescheduler", benchmarkTileScheduler },
+};
+
+namespace rae
+{
+
+String microBenchmarkNames()
+{
+	String names;
+	for (const MicroBenchmark& benchmark : MicroBenchmarks)
+	{
+		if (names.empty() == false)
+			names += ",";
+		names += benchmark.name;
+	}
+	return names;
+}
+
+bool runMicroBenchmarks(const String& nameList)
+{
+	Array<const MicroBenchmark*> selected;
+	std::istringstream names(nameList == "all" ? microBenchmarkNames() : nameList);
+	String name;
+	while (std::getline(names, name, ','))
+	{
+		const MicroBenchmark* found = nullptr;
+		for (const MicroBenchmark& benchmark : MicroBenchmarks)
+		{
+			if (name == benchmark.name)
+				found = &benchmark;
+		}
+		if (found == nullptr)
+		{
+			LOG_F(ERROR, "Unknown micro benchmark: %s", name.c_str());
+			return false;
+		}
+		selected.push_back(found);
+	}
+
+	for (const MicroBenchmark* benchmark : selected)
+	{
+		LOG_F(INFO, "Micro benchmark: %s", benchmark->name);
+		benchmark->run();
+	}
+	return true;
+}
+
+}
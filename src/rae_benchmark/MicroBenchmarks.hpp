@@ -0,0 +1,17 @@
+#pragma once
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+// Timings of the parts of the ray tracer on their own, like the Bvh or the thread pool.
+// They only log what they measure, so there's nothing to compare against a baseline.
+
+// The names of the micro benchmarks, comma separated.
+String microBenchmarkNames();
+
+// Runs the comma separated micro benchmarks, or all of them. Returns false on an unknown name.
+bool runMicroBenchmarks(const String& nameList);
+
+}
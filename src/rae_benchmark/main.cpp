@@ -0,0 +1,472 @@
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#define LOGURU_IMPLEMENTATION 1
+#include "loguru/loguru.hpp"
+
+#include "rae/core/ThreadPool.hpp"
+#include "rae_ray/OfflineRenderer.hpp"
+
+#include "MicroBenchmarks.hpp"
+
+using namespace rae;
+
+// Renders the three scenes with fixed settings, writes the timings as JSON, and compares them
+// to the results of an earlier run to catch performance regressions. With more than one scene,
+// each scene is rendered by running this program again for just that scene, so that the peak
+// memory of a scene doesn't include the scenes before it.
+
+// The metrics of one scene, by name, as they are written to the JSON.
+using BenchmarkResult = std::map<String, double>;
+
+struct Metric
+{
+	const char* name;
+	bool isHigherBetter;
+	// Changes smaller than this are noise, however large they are relative to the value.
+	double noise;
+};
+
+// The ones that are compared. The rest only describe the run.
+static const Metric ComparedMetrics[] =
+{
+	{ "sceneMs", false, 1.0 },
+	{ "bvhBuildMs", false, 1.0 },
+	{ "renderMs", false, 1.0 },
+	{ "samplesPerSecond", true, 0.0 },
+	{ "primaryRaysPerSecond", true, 0.0 },
+	{ "secondaryRaysPerSecond", true, 0.0 },
+	{ "peakMemoryMb", false, 1.0 }
+};
+
+// The settings must match for the results to be comparable.
+static const char* SettingNames[] = { "scene", "width", "height", "spp", "bounces", "seed", "threads" };
+
+static double peakMemoryMb()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return double(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+	return 0.0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0.0;
+	#ifdef __APPLE__
+		return double(usage.ru_maxrss) / (1024.0 * 1024.0); // In bytes.
+	#else
+		return double(usage.ru_maxrss) / 1024.0; // In kilobytes.
+	#endif
+#endif
+}
+
+static BenchmarkResult runScene(int scene, const OfflineRenderSettings& baseSettings)
+{
+	OfflineRenderSettings settings = baseSettings;
+	settings.scene = scene;
+
+	OfflineRenderer renderer(settings);
+	renderer.createScene();
+	renderer.render();
+
+	const OfflineRenderStats& stats = renderer.stats();
+	const double seconds = stats.renderTimeMs / 1000.0;
+
+	BenchmarkResult result;
+	result["scene"] = scene;
+	result["width"] = settings.width;
+	result["height"] = settings.height;
+	result["spp"] = settings.samplesPerPixel;
+	result["bounces"] = settings.bouncesLimit;
+	result["seed"] = double(settings.seed);
+	result["threads"] = stats.threadCount;
+	result["sceneMs"] = stats.sceneTimeMs;
+	result["bvhBuildMs"] = stats.bvhBuildTimeMs;
+	result["renderMs"] = stats.renderTimeMs;
+	result["samplesPerSecond"] = double(stats.sampleCount) / seconds;
+	result["primaryRaysPerSecond"] = double(stats.primaryRayCount) / seconds;
+	result["secondaryRaysPerSecond"] = double(stats.secondaryRayCount) / seconds;
+	// Of the whole process, which renders only this scene.
+	result["peakMemoryMb"] = peakMemoryMb();
+	return result;
+}
+
+static String sceneName(int scene)
+{
+	return "scene" + std::to_string(scene);
+}
+
+static String toJson(const std::map<String, BenchmarkResult>& results)
+{
+	std::ostringstream json;
+	json.precision(10);
+	json << "{\n\t\"results\":\n\t{\n";
+	for (auto it = results.begin(); it != results.end(); ++it)
+	{
+		json << "\t\t\"" << it->first << "\":\n\t\t{\n";
+		for (auto metric = it->second.begin(); metric != it->second.end(); ++metric)
+		{
+			json << "\t\t\t\"" << metric->first << "\": " << metric->second
+				<< (std::next(metric) != it->second.end() ? ",\n" : "\n");
+		}
+		json << "\t\t}" << (std::next(it) != results.end() ? ",\n" : "\n");
+	}
+	json << "\t}\n}\n";
+	return json.str();
+}
+
+// Reads back what toJson() writes: objects of objects of numbers. Doesn't handle arrays,
+// strings as values or escapes.
+class JsonReader
+{
+public:
+	JsonReader(const String& text) : m_text(text) {}
+
+	bool read(std::map<String, BenchmarkResult>& results)
+	{
+		String key;
+		if (expect('{') == false || readString(key) == false || key != "results" || expect(':') == false)
+			return false;
+		if (expect('{') == false)
+			return false;
+
+		if (peek() == '}')
+			return expect('}');
+		do
+		{
+			String name;
+			if (readString(name) == false || expect(':') == false || readObject(results[name]) == false)
+				return false;
+		} while (accept(','));
+		return expect('}') && expect('}');
+	}
+
+protected:
+	bool readObject(BenchmarkResult& result)
+	{
+		if (expect('{') == false)
+			return false;
+		if (peek() == '}')
+			return expect('}');
+		do
+		{
+			String name;
+			if (readString(name) == false || expect(':') == false || readNumber(result[name]) == false)
+				return false;
+		} while (accept(','));
+		return expect('}');
+	}
+
+	bool readString(String& out)
+	{
+		if (expect('"') == false)
+			return false;
+		size_t end = m_text.find('"', m_position);
+		if (end == String::npos)
+			return false;
+		out = m_text.substr(m_position, end - m_position);
+		m_position = end + 1;
+		return true;
+	}
+
+	bool readNumber(double& out)
+	{
+		skipSpace();
+		const char* start = m_text.c_str() + m_position;
+		char* end = nullptr;
+		out = strtod(start, &end);
+		if (end == start)
+			return false;
+		m_position += end - start;
+		return true;
+	}
+
+	char peek()
+	{
+		skipSpace();
+		return m_position < m_text.size() ? m_text[m_position] : '\0';
+	}
+
+	bool accept(char c)
+	{
+		if (peek() != c)
+			return false;
+		m_position++;
+		return true;
+	}
+
+	bool expect(char c)
+	{
+		if (accept(c))
+			return true;
+		LOG_F(ERROR, "Expected '%c' at %i in the baseline.", c, int(m_position));
+		return false;
+	}
+
+	void skipSpace()
+	{
+		while (m_position < m_text.size() && isspace((unsigned char)m_text[m_position]))
+			m_position++;
+	}
+
+	const String& m_text;
+	size_t m_position = 0;
+};
+
+// Prints every compared metric, and returns the number of regressions beyond the threshold.
+static int compare(const std::map<String, BenchmarkResult>& results, const std::map<String, BenchmarkResult>& baseline,
+	double threshold)
+{
+	int regressionCount = 0;
+	for (const auto& entry : results)
+	{
+		auto base = baseline.find(entry.first);
+		if (base == baseline.end())
+		{
+			printf("%s: not in the baseline\n", entry.first.c_str());
+			continue;
+		}
+
+		const BenchmarkResult& current = entry.second;
+		const BenchmarkResult& previous = base->second;
+
+		bool isComparable = true;
+		for (const char* setting : SettingNames)
+		{
+			auto previousSetting = previous.find(setting);
+			if (previousSetting == previous.end() || previousSetting->second != current.at(setting))
+				isComparable = false;
+		}
+		if (isComparable == false)
+		{
+			printf("%s: different settings than in the baseline, not compared\n", entry.first.c_str());
+			continue;
+		}
+
+		for (const Metric& metric : ComparedMetrics)
+		{
+			auto previousValue = previous.find(metric.name);
+			if (previousValue == previous.end() || previousValue->second <= 0.0)
+				continue;
+
+			const double value = current.at(metric.name);
+			// Positive when better.
+			double change = (value - previousValue->second) / previousValue->second;
+			if (metric.isHigherBetter == false)
+				change = -change;
+
+			const bool isRegression = change < -threshold && std::abs(value - previousValue->second) > metric.noise;
+			if (isRegression)
+				regressionCount++;
+			printf("%s %-24s %14.3f -> %14.3f  %+7.2f%%%s\n", entry.first.c_str(), metric.name,
+				previousValue->second, value, 100.0 * change, isRegression ? "  REGRESSION" : "");
+		}
+	}
+	return regressionCount;
+}
+
+// Runs this program for one scene and reads back the results it wrote.
+static bool runSceneInOwnProcess(const char* program, int scene, const OfflineRenderSettings& settings,
+	int threadCount, const String& outFilename, BenchmarkResult& result)
+{
+	const String sceneFilename = outFilename + "." + sceneName(scene);
+	std::ostringstream command;
+	command << '"' << program << "\" --scenes " << scene << " --out \"" << sceneFilename << '"'
+		<< " --res " << settings.width << 'x' << settings.height << " --spp " << settings.samplesPerPixel;
+	if (threadCount > 0)
+		command << " --threads " << threadCount;
+
+	if (std::system(command.str().c_str()) != 0)
+	{
+		LOG_F(ERROR, "Failed to run: %s", command.str().c_str());
+		return false;
+	}
+
+	std::ifstream sceneFile(sceneFilename);
+	std::stringstream sceneText;
+	sceneText << sceneFile.rdbuf();
+	sceneFile.close();
+	std::remove(sceneFilename.c_str());
+
+	const String text = sceneText.str();
+	std::map<String, BenchmarkResult> sceneResults;
+	if (JsonReader(text).read(sceneResults) == false || sceneResults.count(sceneName(scene)) == 0)
+	{
+		LOG_F(ERROR, "Failed to read the results of %s", sceneName(scene).c_str());
+		return false;
+	}
+	result = sceneResults[sceneName(scene)];
+	return true;
+}
+
+static void printUsage()
+{
+	printf("Usage: rae_benchmark [options]\n"
+		"  --out FILE         Writes the results as JSON. Default rae_benchmark.json.\n"
+		"  --compare FILE     Compares the results to an earlier run, and fails if any are worse.\n"
+		"  --threshold X      How much worse is a regression, relative. Default 0.1.\n"
+		"  --scenes LIST      Comma separated scene numbers, 1 to 4 as in rae_render. Default 1,2,3.\n"
+		"  --res WxH          Resolution. Default 640x360.\n"
+		"  --spp N            Samples per pixel. Default 16.\n"
+		"  --threads N        Number of threads. Default one per hardware thread.\n"
+		"  --micro LIST       Runs and logs the comma separated micro benchmarks instead of the scenes,\n"
+		"                     or all of them: %s\n", microBenchmarkNames().c_str());
+}
+
+int main(int argc, char** argv)
+{
+	loguru::init(argc, argv);
+
+	OfflineRenderSettings settings;
+	settings.width = 640;
+	settings.height = 360;
+	settings.samplesPerPixel = 16;
+	settings.bouncesLimit = 50;
+	settings.seed = 1;
+
+	String outFilename = "rae_benchmark.json";
+	String baselineFilename;
+	double threshold = 0.1;
+	String sceneList = "1,2,3";
+	String microBenchmarkList;
+	int threadCount = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* option = argv[i];
+		if (strcmp(option, "--help") == 0 || strcmp(option, "-h") == 0)
+		{
+			printUsage();
+			return 0;
+		}
+
+		if (i + 1 >= argc)
+		{
+			LOG_F(ERROR, "Missing the value of %s.", option);
+			printUsage();
+			return 1;
+		}
+		const char* value = argv[++i];
+
+		if (strcmp(option, "--out") == 0)
+			outFilename = value;
+		else if (strcmp(option, "--compare") == 0)
+			baselineFilename = value;
+		else if (strcmp(option, "--threshold") == 0)
+			threshold = atof(value);
+		else if (strcmp(option, "--scenes") == 0)
+			sceneList = value;
+		else if (strcmp(option, "--res") == 0)
+		{
+			if (sscanf(value, "%ix%i", &settings.width, &settings.height) != 2)
+				settings.width = 0;
+		}
+		else if (strcmp(option, "--spp") == 0)
+			settings.samplesPerPixel = atoi(value);
+		else if (strcmp(option, "--threads") == 0)
+			threadCount = atoi(value);
+		else if (strcmp(option, "--micro") == 0)
+			microBenchmarkList = value;
+		else
+		{
+			LOG_F(ERROR, "Unknown option: %s", option);
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (settings.width <= 0 || settings.height <= 0 || settings.samplesPerPixel <= 0 || threadCount < 0)
+	{
+		LOG_F(ERROR, "Invalid options.");
+		printUsage();
+		return 1;
+	}
+
+	if (threadCount > 0)
+		setThreadPoolWorkerCount(threadCount - 1);
+
+	if (microBenchmarkList.empty() == false)
+		return runMicroBenchmarks(microBenchmarkList) ? 0 : 1;
+
+	Array<int> sceneNumbers;
+	std::istringstream scenes(sceneList);
+	String sceneText;
+	while (std::getline(scenes, sceneText, ','))
+	{
+		const int scene = atoi(sceneText.c_str());
+		if (OfflineRenderer::isValidScene(scene) == false)
+		{
+			LOG_F(ERROR, "Unknown scene: %s", sceneText.c_str());
+			return 1;
+		}
+		sceneNumbers.push_back(scene);
+	}
+
+	std::map<String, BenchmarkResult> results;
+	for (int scene : sceneNumbers)
+	{
+		if (sceneNumbers.size() > 1)
+		{
+			// The other process prints the results of the scene.
+			if (runSceneInOwnProcess(argv[0], scene, settings, threadCount, outFilename, results[sceneName(scene)]) == false)
+				return 1;
+			continue;
+		}
+
+		const BenchmarkResult result = runScene(scene, settings);
+		results[sceneName(scene)] = result;
+		printf("%s: bvh %f ms, render %f ms, %f Msamples/s, %f primary Mrays/s, %f secondary Mrays/s, peak %f MB\n",
+			sceneName(scene).c_str(), result.at("bvhBuildMs"), result.at("renderMs"),
+			result.at("samplesPerSecond") / 1.0e6, result.at("primaryRaysPerSecond") / 1.0e6,
+			result.at("secondaryRaysPerSecond") / 1.0e6, result.at("peakMemoryMb"));
+	}
+
+	std::ofstream out(outFilename);
+	out << toJson(results);
+	if (out.good() == false)
+	{
+		LOG_F(ERROR, "Failed to write %s", outFilename.c_str());
+		return 1;
+	}
+	printf("Wrote %s\n", outFilename.c_str());
+
+	if (baselineFilename.empty())
+		return 0;
+
+	std::ifstream baselineFile(baselineFilename);
+	std::stringstream baselineText;
+	baselineText << baselineFile.rdbuf();
+	const String text = baselineText.str();
+
+	std::map<String, BenchmarkResult> baseline;
+	if (baselineFile.is_open() == false || JsonReader(text).read(baseline) == false)
+	{
+		LOG_F(ERROR, "Failed to read the baseline %s", baselineFilename.c_str());
+		return 1;
+	}
+
+	const int regressionCount = compare(results, baseline, threshold);
+	if (regressionCount > 0)
+	{
+		printf("%i regressions of more than %f%% against %s\n", regressionCount, 100.0 * threshold, baselineFilename.c_str());
+		return 2;
+	}
+	printf("No regressions against %s\n", baselineFilename.c_str());
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "rae_ray/AccumulationBuffer.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace rae;
+
+void AccumulationBuffer::init(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_pixels.assign(width * height, Pixel());
+}
+
+void AccumulationBuffer::clear()
+{
+	std::fill(m_pixels.begin(), m_pixels.end(), Pixel());
+}
+
+void AccumulationBuffer::addSample(int x, int y, const vec3& color, const FirstHit& firstHit)
+{
+	Pixel& target = m_pixels[y * m_width + x];
+	target.colorSum += color;
+	target.sampleCount++;
+
+	target.albedoSum += firstHit.albedo;
+	target.normalSum += firstHit.normal;
+	target.depthSum += firstHit.depth;
+	target.positionSum += firstHit.position;
+
+	const float value = luminance(color);
+	const float delta = value - target.luminanceMean;
+	target.luminanceMean += delta / float(target.sampleCount);
+	target.luminanceM2 += delta * (value - target.luminanceMean);
+}
+
+vec3 AccumulationBuffer::color(int x, int y) const
+{
+	const Pixel& source = pixel(x, y);
+	if (source.sampleCount == 0)
+		return vec3(0.0f, 0.0f, 0.0f);
+	return source.colorSum / float(source.sampleCount);
+}
+
+vec3 AccumulationBuffer::albedo(int x, int y) const
+{
+	const Pixel& source = pixel(x, y);
+	return source.albedoSum / float(std::max(1, source.sampleCount));
+}
+
+vec3 AccumulationBuffer::normal(int x, int y) const
+{
+	const Pixel& source = pixel(x, y);
+	return source.normalSum / float(std::max(1, source.sampleCount));
+}
+
+float AccumulationBuffer::depth(int x, int y) const
+{
+	const Pixel& source = pixel(x, y);
+	return source.depthSum / float(std::max(1, source.sampleCount));
+}
+
+vec3 AccumulationBuffer::position(int x, int y) const
+{
+	const Pixel& source = pixel(x, y);
+	return source.positionSum / float(std::max(1, source.sampleCount));
+}
+
+float AccumulationBuffer::standardError(int x, int y) const
+{
+	const Pixel& source = pixel(x, y);
+	if (source.sampleCount < 2)
+		return FLT_MAX;
+
+	const float variance = source.luminanceM2 / float(source.sampleCount - 1);
+	return std::sqrt(variance / float(source.sampleCount));
+}
+
+float AccumulationBuffer::relativeError(int x, int y) const
+{
+	const float error = standardError(x, y);
+	if (error == FLT_MAX)
+		return FLT_MAX;
+	// A small floor, so that nearly black pixels don't need endless samples.
+	return error / std::max(pixel(x, y).luminanceMean, 0.01f);
+}
+
+bool AccumulationBuffer::isConverged(int x, int y, float errorThreshold, int minSamples) const
+{
+	return sampleCount(x, y) >= minSamples && relativeError(x, y) < errorThreshold;
+}
+
+void AccumulationBuffer::setFromHistory(int x, int y, const AccumulationBuffer& history, int historyX, int historyY,
+	float depth, int maxSamples)
+{
+	Pixel& target = m_pixels[y * m_width + x];
+	target = history.pixel(historyX, historyY);
+	if (target.sampleCount > maxSamples)
+	{
+		// Scaled down to fewer samples with the same averages and about the same variance.
+		const float scale = float(maxSamples) / float(target.sampleCount);
+		target.colorSum *= scale;
+		target.luminanceM2 *= scale;
+		target.sampleCount = maxSamples;
+		target.albedoSum *= scale;
+		target.normalSum *= scale;
+		target.positionSum *= scale;
+	}
+	target.depthSum = depth * float(target.sampleCount);
+}
+
+float rae::luminance(const vec3& color)
+{
+	return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+}
+
+vec3 rae::heatmapColor(float value)
+{
+	value = std::min(std::max(value, 0.0f), 1.0f);
+	if (value < 1.0f / 3.0f)
+		return glm::mix(vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f), 3.0f * value);
+	if (value < 2.0f / 3.0f)
+		return glm::mix(vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 1.0f, 0.0f), 3.0f * value - 1.0f);
+	return glm::mix(vec3(1.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), 3.0f * value - 2.0f);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "rae/core/Types.hpp"
+#include "rae_ray/PathTracer.hpp"
+
+namespace rae
+{
+
+// The samples of every pixel added up so far, with a running estimate of their variance,
+// so that the renderer can tell which pixels still need more samples.
+class AccumulationBuffer
+{
+public:
+	void init(int width, int height);
+	void clear();
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+
+	void addSample(int x, int y, const vec3& color, const FirstHit& firstHit = FirstHit());
+
+	// The average of the samples.
+	vec3 color(int x, int y) const;
+	// Averages of the first hits of the samples, for the denoiser. The normal is not normalized.
+	vec3 albedo(int x, int y) const;
+	vec3 normal(int x, int y) const;
+	float depth(int x, int y) const;
+	vec3 position(int x, int y) const;
+	int sampleCount(int x, int y) const { return pixel(x, y).sampleCount; }
+
+	// The standard error of the average luminance. Huge until there are a couple of samples.
+	float standardError(int x, int y) const;
+	// The standard error of the average luminance relative to the luminance, roughly how much
+	// the pixel could still change. Huge until there are a couple of samples.
+	float relativeError(int x, int y) const;
+	// Enough samples and a relative error below the threshold.
+	bool isConverged(int x, int y, float errorThreshold, int minSamples) const;
+
+	// Replaces pixel (x, y) with the samples of pixel (historyX, historyY) of another buffer, for
+	// reusing them after the camera has moved. Keeps at most maxSamples worth of them, so that
+	// the new samples soon outweigh whatever has changed. Depth is the distance from the new camera.
+	void setFromHistory(int x, int y, const AccumulationBuffer& history, int historyX, int historyY,
+		float depth, int maxSamples);
+
+protected:
+	struct Pixel
+	{
+		vec3 colorSum = vec3(0.0f, 0.0f, 0.0f);
+		// Welford's online variance of the luminance.
+		float luminanceMean = 0.0f;
+		float luminanceM2 = 0.0f;
+		int sampleCount = 0;
+
+		vec3 albedoSum = vec3(0.0f, 0.0f, 0.0f);
+		vec3 normalSum = vec3(0.0f, 0.0f, 0.0f);
+		float depthSum = 0.0f;
+		vec3 positionSum = vec3(0.0f, 0.0f, 0.0f);
+	};
+
+	const Pixel& pixel(int x, int y) const { return m_pixels[y * m_width + x]; }
+
+	int m_width = 0;
+	int m_height = 0;
+	Array<Pixel> m_pixels;
+};
+
+float luminance(const vec3& color);
+
+// From blue for 0 through green and yellow to red for 1, for heatmaps.
+vec3 heatmapColor(float value);
+
+}
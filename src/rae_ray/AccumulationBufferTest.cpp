@@ -0,0 +1,60 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cmath>
+
+#include "rae_ray/AccumulationBuffer.hpp"
+
+using namespace rae;
+
+SCENARIO("AccumulationBuffer unittest", "[rae][AccumulationBuffer]")
+{
+	GIVEN( "a buffer with a flat pixel and a noisy pixel" )
+	{
+		AccumulationBuffer buffer;
+		buffer.init(2, 1);
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			buffer.addSample(0, 0, vec3(0.5f, 0.5f, 0.5f));
+			// Luminance 0 or 1 with equal odds: mean 0.5, variance 0.25.
+			float value = (i % 2 == 0) ? 1.0f : 0.0f;
+			buffer.addSample(1, 0, vec3(value, value, value));
+		}
+
+		THEN( "the colors are the averages" )
+		{
+			REQUIRE(buffer.sampleCount(0, 0) == 1000);
+			REQUIRE(std::abs(buffer.color(0, 0).r - 0.5f) < 0.0001f);
+			REQUIRE(std::abs(buffer.color(1, 0).g - 0.5f) < 0.0001f);
+		}
+
+		THEN( "the error follows the variance and the sample count" )
+		{
+			REQUIRE(buffer.relativeError(0, 0) < 0.0001f);
+			// sqrt(0.25 / 1000) / 0.5
+			REQUIRE(std::abs(buffer.relativeError(1, 0) - 0.0316f) < 0.001f);
+
+			REQUIRE(buffer.isConverged(0, 0, 0.01f, 16) == true);
+			REQUIRE(buffer.isConverged(1, 0, 0.01f, 16) == false);
+			REQUIRE(buffer.isConverged(1, 0, 0.05f, 16) == true);
+			REQUIRE(buffer.isConverged(1, 0, 0.05f, 2000) == false);
+		}
+
+		WHEN( "it is cleared" )
+		{
+			buffer.clear();
+
+			THEN( "there are no samples and nothing has converged" )
+			{
+				REQUIRE(buffer.sampleCount(1, 0) == 0);
+				REQUIRE(buffer.color(1, 0) == vec3(0.0f, 0.0f, 0.0f));
+				REQUIRE(buffer.isConverged(0, 0, 0.01f, 0) == false);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,561 @@
+#include "rae_ray/Bvh.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+
+#include "loguru/loguru.hpp"
+
+#include "rae/core/ThreadPool.hpp"
+#include "rae/core/Utils.hpp"
+
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/HitRecord.hpp"
+
+using namespace rae;
+
+const int BvhTree::MaxDepth;
+const int BvhTree::ParallelBuildThreshold;
+const int BvhTree::ParallelRefitThreshold;
+constexpr float BvhTree::TraversalCost;
+constexpr float BvhTree::IntersectionCost;
+constexpr float Bvh::DefaultMaxSahCostGrowth;
+
+void BvhTree::clear()
+{
+	m_nodes.clear();
+	m_primitiveIndices.clear();
+	m_stats = BvhStats();
+	m_builtSahCost = 0.0f;
+}
+
+void BvhTree::build(const Array<Box>& aabbs, const BvhBuildOptions& options)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	clear();
+	m_options = options;
+
+	if (aabbs.empty())
+		return;
+
+	Array<BuildPrimitive> primitives;
+	primitives.reserve(aabbs.size());
+	for (int i = 0; i < (int)aabbs.size(); ++i)
+	{
+		BuildPrimitive primitive;
+		primitive.aabb = aabbs[i];
+		primitive.centroid = primitive.aabb.center();
+		primitive.index = i;
+		primitives.push_back(primitive);
+	}
+
+	// A binary tree has at most 2n-1 nodes.
+	m_nodes.reserve(2 * primitives.size());
+	buildRecursive(m_nodes, primitives, 0, (int)primitives.size(), 0);
+
+	// The build partitioned the primitives in place, so the leaves refer to ranges in this order.
+	m_primitiveIndices.reserve(primitives.size());
+	for (auto&& primitive : primitives)
+	{
+		m_primitiveIndices.push_back(primitive.index);
+	}
+
+	computeStats();
+	m_builtSahCost = m_stats.sahCost;
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_stats.buildTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+void BvhTree::refit(const Array<Box>& aabbs)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	if (m_nodes.empty())
+		return;
+
+	if (aabbs.size() != m_primitiveIndices.size())
+	{
+		LOG_F(ERROR, "BvhTree::refit got %i boxes for %i primitives.", (int)aabbs.size(), primitiveCount());
+		return;
+	}
+
+	// Split the tree from the top into subtrees small enough to refit as one task. A subtree is a
+	// contiguous range of nodes: the first child's ends where the second child begins.
+	struct NodeRange
+	{
+		int begin;
+		int end;
+	};
+	Array<NodeRange> subtrees;
+	Array<int> topNodes; // The interior nodes above the subtrees, parents before children.
+	Array<NodeRange> ranges;
+	ranges.push_back({ 0, (int)m_nodes.size() });
+	for (int i = 0; i < (int)ranges.size(); ++i)
+	{
+		const NodeRange range = ranges[i];
+		const BvhNode& node = m_nodes[range.begin];
+		if (m_options.allowParallel == false || node.isLeaf() || range.end - range.begin <= ParallelRefitThreshold)
+		{
+			subtrees.push_back(range);
+			continue;
+		}
+
+		topNodes.push_back(range.begin);
+		ranges.push_back({ range.begin + 1, node.offset });
+		ranges.push_back({ node.offset, range.end });
+	}
+
+	Array<float> subtreeCosts(subtrees.size(), 0.0f);
+	if (subtrees.size() == 1)
+	{
+		subtreeCosts[0] = refitRange(aabbs, subtrees[0].begin, subtrees[0].end);
+	}
+	else
+	{
+		parallel_for(0, (int)subtrees.size(), [&](int i)
+		{
+			subtreeCosts[i] = refitRange(aabbs, subtrees[i].begin, subtrees[i].end);
+		}, 1);
+	}
+
+	float sahCost = 0.0f;
+	for (float cost : subtreeCosts)
+	{
+		sahCost += cost;
+	}
+	for (auto it = topNodes.rbegin(); it != topNodes.rend(); ++it)
+	{
+		sahCost += refitNode(aabbs, *it);
+	}
+	m_stats.sahCost = sahCost / std::max(getAabb().surfaceArea(), FLT_MIN);
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_stats.refitTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+float BvhTree::refitRange(const Array<Box>& aabbs, int begin, int end)
+{
+	float sahCost = 0.0f;
+	for (int nodeIndex = end - 1; nodeIndex >= begin; --nodeIndex)
+	{
+		sahCost += refitNode(aabbs, nodeIndex);
+	}
+	return sahCost;
+}
+
+float BvhTree::refitNode(const Array<Box>& aabbs, int nodeIndex)
+{
+	BvhNode& node = m_nodes[nodeIndex];
+
+	// Growing by an empty box would make it cover everything.
+	Box aabb;
+	auto growValid = [&aabb](const Box& other)
+	{
+		if (other.valid())
+			aabb.grow(other);
+	};
+
+	float cost;
+	if (node.isLeaf())
+	{
+		for (int i = node.offset; i < node.offset + node.primitiveCount; ++i)
+		{
+			growValid(aabbs[m_primitiveIndices[i]]);
+		}
+		cost = IntersectionCost * float(node.primitiveCount);
+	}
+	else
+	{
+		const BvhNode& first = m_nodes[nodeIndex + 1];
+		const BvhNode& second = m_nodes[node.offset];
+		growValid(Box(first.min, first.max));
+		growValid(Box(second.min, second.max));
+		cost = TraversalCost;
+	}
+
+	node.min = aabb.min();
+	node.max = aabb.max();
+	return aabb.surfaceArea() * cost;
+}
+
+int BvhTree::createLeaf(Array<BvhNode>& nodes, const Box& aabb, int begin, int end)
+{
+	int nodeIndex = (int)nodes.size();
+	nodes.emplace_back();
+	BvhNode& node = nodes.back();
+	node.min = aabb.min();
+	node.max = aabb.max();
+	node.offset = begin;
+	node.primitiveCount = uint16_t(end - begin);
+	node.axis = 0;
+	node.pad = 0;
+	return nodeIndex;
+}
+
+// Appends a subtree that was built into its own array. Leaves refer to the shared
+// primitive array already, so only the child offsets of interior nodes need to move.
+static void appendSubtree(Array<BvhNode>& nodes, const Array<BvhNode>& subtree)
+{
+	const int32_t base = (int32_t)nodes.size();
+	for (auto&& node : subtree)
+	{
+		nodes.push_back(node);
+		if (node.isLeaf() == false)
+			nodes.back().offset += base;
+	}
+}
+
+int BvhTree::buildRecursive(Array<BvhNode>& nodes, Array<BuildPrimitive>& primitives,
+	int begin, int end, int depth)
+{
+	Box aabb;
+	Box centroidBounds;
+	for (int i = begin; i < end; ++i)
+	{
+		aabb.grow(primitives[i].aabb);
+		centroidBounds.grow(primitives[i].centroid);
+	}
+
+	const int count = end - begin;
+	if (count == 1 || depth >= MaxDepth - 1)
+	{
+		return createLeaf(nodes, aabb, begin, end);
+	}
+
+	int axis = 0;
+	int middle = -1;
+	if (m_options.splitMethod == BvhSplitMethod::Sah)
+	{
+		middle = splitSah(primitives, begin, end, aabb, centroidBounds, axis);
+	}
+	else if (count > m_options.maxPrimitivesInLeaf)
+	{
+		middle = splitMedian(primitives, begin, end, centroidBounds, axis);
+	}
+
+	if (middle == -1)
+	{
+		if (count <= m_options.maxPrimitivesInLeaf)
+			return createLeaf(nodes, aabb, begin, end);
+
+		// The centroids couldn't be separated, but there are too many primitives for one leaf.
+		middle = splitMedian(primitives, begin, end, centroidBounds, axis);
+	}
+
+	int nodeIndex = (int)nodes.size();
+	nodes.emplace_back();
+
+	int secondChild;
+	if (m_options.allowParallel && count >= ParallelBuildThreshold)
+	{
+		// The halves don't share any primitives, so they can be built at the same time into their own arrays.
+		Array<BvhNode> firstNodes;
+		Array<BvhNode> secondNodes;
+		{
+			TaskGroup group;
+			group.run([&]()
+			{
+				buildRecursive(firstNodes, primitives, begin, middle, depth + 1);
+			});
+			buildRecursive(secondNodes, primitives, middle, end, depth + 1);
+			group.wait();
+		}
+
+		appendSubtree(nodes, firstNodes); // The first child is the next node.
+		secondChild = (int)nodes.size();
+		appendSubtree(nodes, secondNodes);
+	}
+	else
+	{
+		buildRecursive(nodes, primitives, begin, middle, depth + 1); // The first child is the next node.
+		secondChild = buildRecursive(nodes, primitives, middle, end, depth + 1);
+	}
+
+	// Don't keep a reference over the recursion, it could reallocate.
+	BvhNode& node = nodes[nodeIndex];
+	node.min = aabb.min();
+	node.max = aabb.max();
+	node.offset = secondChild;
+	node.primitiveCount = 0;
+	node.axis = uint8_t(axis);
+	node.pad = 0;
+	return nodeIndex;
+}
+
+int BvhTree::splitMedian(Array<BuildPrimitive>& primitives, int begin, int end,
+	const Box& centroidBounds, int& outAxis) const
+{
+	// Split at the median centroid along the axis where the centroids are spread the widest.
+	vec3 extent = centroidBounds.dimensions();
+	int axis = 0;
+	if (extent.y > extent.x)
+		axis = 1;
+	if (extent.z > extent[axis])
+		axis = 2;
+
+	const int middle = begin + (end - begin) / 2;
+	std::nth_element(primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end,
+		[axis](const BuildPrimitive& a, const BuildPrimitive& b)
+		{
+			return a.centroid[axis] < b.centroid[axis];
+		});
+
+	outAxis = axis;
+	return middle;
+}
+
+namespace
+{
+	const int SahBinCount = 12;
+
+	struct SahBin
+	{
+		Box aabb;
+		int count = 0;
+	};
+
+	inline int sahBinIndex(float centroid, float boundsMin, float scale)
+	{
+		int index = int((centroid - boundsMin) * scale);
+		return std::min(std::max(index, 0), SahBinCount - 1);
+	}
+}
+
+int BvhTree::splitSah(Array<BuildPrimitive>& primitives, int begin, int end,
+	const Box& aabb, const Box& centroidBounds, int& outAxis) const
+{
+	const int count = end - begin;
+	const vec3 extent = centroidBounds.dimensions();
+
+	// How many intersection tests it takes to go through n primitives.
+	const int batchSize = m_options.primitiveBatchSize;
+	auto batchCount = [batchSize](int n)
+	{
+		return float((n + batchSize - 1) / batchSize);
+	};
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestBin = -1;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (extent[axis] <= 0.0f)
+			continue;
+
+		const float boundsMin = centroidBounds.min()[axis];
+		const float scale = float(SahBinCount) / extent[axis];
+
+		SahBin bins[SahBinCount];
+		for (int i = begin; i < end; ++i)
+		{
+			SahBin& bin = bins[sahBinIndex(primitives[i].centroid[axis], boundsMin, scale)];
+			bin.count++;
+			bin.aabb.grow(primitives[i].aabb);
+		}
+
+		// Sweep from the right to get the area and count on the right side of every split plane.
+		float rightArea[SahBinCount - 1];
+		int rightCount[SahBinCount - 1];
+		Box rightBox;
+		int rightSum = 0;
+		for (int b = SahBinCount - 1; b > 0; --b)
+		{
+			if (bins[b].count > 0)
+				rightBox.grow(bins[b].aabb);
+			rightSum += bins[b].count;
+			rightArea[b - 1] = rightBox.surfaceArea();
+			rightCount[b - 1] = rightSum;
+		}
+
+		// And from the left to evaluate the cost of each plane.
+		Box leftBox;
+		int leftSum = 0;
+		for (int b = 0; b < SahBinCount - 1; ++b)
+		{
+			if (bins[b].count > 0)
+				leftBox.grow(bins[b].aabb);
+			leftSum += bins[b].count;
+
+			if (leftSum == 0 || rightCount[b] == 0)
+				continue;
+
+			float cost = batchCount(leftSum) * leftBox.surfaceArea() + batchCount(rightCount[b]) * rightArea[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	if (bestAxis == -1)
+		return -1; // All the centroids are in the same place.
+
+	const float parentArea = std::max(aabb.surfaceArea(), FLT_MIN);
+	const float splitCost = TraversalCost + IntersectionCost * bestCost / parentArea;
+	const float leafCost = IntersectionCost * batchCount(count);
+	if (count <= m_options.maxPrimitivesInLeaf && leafCost <= splitCost)
+		return -1;
+
+	const float boundsMin = centroidBounds.min()[bestAxis];
+	const float scale = float(SahBinCount) / extent[bestAxis];
+	auto middle = std::partition(primitives.begin() + begin, primitives.begin() + end,
+		[bestAxis, bestBin, boundsMin, scale](const BuildPrimitive& primitive)
+		{
+			return sahBinIndex(primitive.centroid[bestAxis], boundsMin, scale) <= bestBin;
+		});
+
+	outAxis = bestAxis;
+	return int(middle - primitives.begin());
+}
+
+void BvhTree::computeStats()
+{
+	m_stats.nodeCount = (int)m_nodes.size();
+	if (m_nodes.empty())
+		return;
+
+	const float rootArea = std::max(getAabb().surfaceArea(), FLT_MIN);
+
+	struct StackItem
+	{
+		int nodeIndex;
+		int depth;
+	};
+	Array<StackItem> stack;
+	stack.push_back({ 0, 0 });
+
+	int leafPrimitives = 0;
+	while (!stack.empty())
+	{
+		StackItem item = stack.back();
+		stack.pop_back();
+
+		const BvhNode& node = m_nodes[item.nodeIndex];
+		const float relativeArea = Box(node.min, node.max).surfaceArea() / rootArea;
+		m_stats.maxDepth = std::max(m_stats.maxDepth, item.depth);
+
+		if (node.isLeaf())
+		{
+			m_stats.leafCount++;
+			m_stats.maxLeafSize = std::max(m_stats.maxLeafSize, (int)node.primitiveCount);
+			leafPrimitives += node.primitiveCount;
+			m_stats.sahCost += relativeArea * IntersectionCost * float(node.primitiveCount);
+		}
+		else
+		{
+			m_stats.sahCost += relativeArea * TraversalCost;
+			stack.push_back({ item.nodeIndex + 1, item.depth + 1 });
+			stack.push_back({ node.offset, item.depth + 1 });
+		}
+	}
+
+	m_stats.averageLeafSize = float(leafPrimitives) / float(m_stats.leafCount);
+}
+
+Box BvhTree::getAabb() const
+{
+	if (m_nodes.empty())
+		return Box();
+	return Box(m_nodes[0].min, m_nodes[0].max);
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+Bvh::Bvh(const Array<Hitable*>& hitables, BvhSplitMethod splitMethod)
+{
+	build(hitables, splitMethod);
+}
+
+void Bvh::clear()
+{
+	m_tree.clear();
+	m_primitives.clear();
+}
+
+void Bvh::build(const Array<Hitable*>& hitables, BvhSplitMethod splitMethod)
+{
+	clear();
+
+	Array<Box> aabbs;
+	Array<Hitable*> validHitables;
+	aabbs.reserve(hitables.size());
+	validHitables.reserve(hitables.size());
+	for (int i = 0; i < (int)hitables.size(); ++i)
+	{
+		Box aabb = hitables[i]->getAabb(0.0f, 0.0f);
+		if (aabb.valid() == false)
+		{
+			LOG_F(ERROR, "No aabb for hitable %i in Bvh::build.", i);
+			continue;
+		}
+		aabbs.push_back(aabb);
+		validHitables.push_back(hitables[i]);
+	}
+
+	m_splitMethod = splitMethod;
+	BvhBuildOptions options;
+	options.splitMethod = splitMethod;
+	m_tree.build(aabbs, options);
+
+	m_primitives.reserve(validHitables.size());
+	for (int index : m_tree.primitiveIndices())
+	{
+		m_primitives.push_back(validHitables[index]);
+	}
+}
+
+bool Bvh::update(float maxSahCostGrowth)
+{
+	if (m_tree.isEmpty())
+		return false;
+
+	// The tree wants the boxes in the order they were given to build.
+	const Array<int>& primitiveIndices = m_tree.primitiveIndices();
+	Array<Box> aabbs(m_primitives.size());
+	parallel_for(0, (int)m_primitives.size(), [&](int i)
+	{
+		aabbs[primitiveIndices[i]] = m_primitives[i]->getAabb(0.0f, 0.0f);
+	});
+	m_tree.refit(aabbs);
+
+	if (m_tree.stats().sahCost <= maxSahCostGrowth * m_tree.builtSahCost())
+		return false;
+
+	LOG_F(INFO, "Bvh SAH cost grew from %f to %f with refits. Rebuilding.", m_tree.builtSahCost(), m_tree.stats().sahCost);
+	const Array<Hitable*> hitables = m_primitives; // The build clears them.
+	build(hitables, m_splitMethod);
+	return true;
+}
+
+bool Bvh::hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const
+{
+	return m_tree.traverse(ray, t_min, t_max, [&](int primitive, float nearT, float& farT)
+	{
+		// Hitables only write to the record when they hit closer than farT,
+		// so we can shrink it and pass the same record on.
+		if (m_primitives[primitive]->hit(ray, nearT, farT, record))
+		{
+			farT = record.t;
+			return true;
+		}
+		return false;
+	});
+}
+
+bool Bvh::occluded(const Ray& ray, float t_min, float t_max) const
+{
+	return m_tree.traverseAny(ray, t_min, t_max, [&](int primitive, float nearT, float& farT)
+	{
+		return m_primitives[primitive]->occluded(ray, nearT, farT);
+	});
+}
+
+Box Bvh::getAabb(float /*t0*/, float /*t1*/) const
+{
+	return m_tree.getAabb();
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+
+#include "rae/core/Types.hpp"
+
+#include "rae_ray/Hitable.hpp"
+#include "rae_ray/RayStats.hpp"
+#include "rae/visual/Box.hpp"
+#include "rae/visual/Ray.hpp"
+
+namespace rae
+{
+
+struct HitRecord;
+
+// One node of the flattened Bvh. 32 bytes, so two nodes fit in a cache line.
+// The first child of an interior node is always the next node in the array,
+// and offset tells where the second child is. For leaves offset is the index of
+// the first primitive, and primitiveCount tells how many there are.
+struct BvhNode
+{
+	bool isLeaf() const { return primitiveCount > 0; }
+
+	vec3 min;
+	int32_t offset;
+	vec3 max;
+	uint16_t primitiveCount; // 0 for interior nodes
+	uint8_t axis; // The split axis of interior nodes
+	uint8_t pad;
+};
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode is supposed to be 32 bytes.");
+
+enum class BvhSplitMethod
+{
+	Median, // Split at the median centroid of the widest axis. Fast to build, slower to trace.
+	Sah // Surface area heuristic evaluated on binned centroids.
+};
+
+struct BvhBuildOptions
+{
+	BvhSplitMethod splitMethod = BvhSplitMethod::Sah;
+	// Leaves can hold up to this many primitives when the SAH says it is cheaper than splitting.
+	int maxPrimitivesInLeaf = 4;
+	// For primitives that are intersected several at a time, like the SIMD triangle batches.
+	// The SAH then counts a leaf as one intersection per batch, which favours full batches.
+	int primitiveBatchSize = 1;
+	// Build big subtrees on the thread pool. Turn it off when the other threads are blocked
+	// waiting for the tree anyway, and couldn't help with the subtrees.
+	bool allowParallel = true;
+};
+
+// Build time and tree quality of the last Bvh::build.
+struct BvhStats
+{
+	double buildTimeMs = 0.0;
+	double refitTimeMs = 0.0; // Of the last refit since the build.
+	// Expected cost of a random ray relative to intersecting one primitive. Smaller is better.
+	float sahCost = 0.0f;
+	int nodeCount = 0;
+	int leafCount = 0;
+	int maxDepth = 0;
+	int maxLeafSize = 0;
+	float averageLeafSize = 0.0f;
+};
+
+// Bounding volume hierarchy over plain bounding boxes, stored as a contiguous array of BvhNodes
+// in depth first order. It doesn't know what the primitives are: leaves refer to a range in
+// primitiveIndices(), which maps back to the boxes given to build(). Bvh uses this for hitables
+// and Mesh for its triangles.
+class BvhTree
+{
+public:
+	void build(const Array<Box>& aabbs, const BvhBuildOptions& options = BvhBuildOptions());
+	void clear();
+	// Recomputes the node bounds bottom-up for new boxes of the same primitives, in the same order
+	// as given to build(). The nodes stay as they are, so the tree gets slower to trace the further
+	// the primitives move: compare stats().sahCost, which is updated, to builtSahCost().
+	void refit(const Array<Box>& aabbs);
+
+	// Visits the leaves the ray passes through, near child first. For each primitive in them
+	// calls hitPrimitive(int primitive, float t_min, float& t_max), where primitive is the
+	// position in primitiveIndices(). It should shrink t_max and return true on a hit.
+	template <typename HitPrimitive>
+	bool traverse(const Ray& ray, float t_min, float t_max, HitPrimitive&& hitPrimitive) const;
+	// Same, but calls hitLeaf(int begin, int end, float t_min, float& t_max) once per leaf with
+	// the range of primitives in it. For primitives that are intersected in batches.
+	template <typename HitLeaf>
+	bool traverseLeaves(const Ray& ray, float t_min, float t_max, HitLeaf&& hitLeaf) const;
+	// Like traverse and traverseLeaves, but return at the first hit. For shadow rays, where
+	// any hit will do.
+	template <typename HitPrimitive>
+	bool traverseAny(const Ray& ray, float t_min, float t_max, HitPrimitive&& hitPrimitive) const;
+	template <typename HitLeaf>
+	bool traverseLeavesAny(const Ray& ray, float t_min, float t_max, HitLeaf&& hitLeaf) const;
+
+	Box getAabb() const;
+
+	bool isEmpty() const { return m_nodes.empty(); }
+	int nodeCount() const { return (int)m_nodes.size(); }
+	int primitiveCount() const { return (int)m_primitiveIndices.size(); }
+	const Array<BvhNode>& nodes() const { return m_nodes; }
+	// Indices to the boxes given to build(), in the order the leaves refer to them.
+	const Array<int>& primitiveIndices() const { return m_primitiveIndices; }
+	const BvhStats& stats() const { return m_stats; }
+	// The SAH cost right after the last build, before any refits.
+	float builtSahCost() const { return m_builtSahCost; }
+
+	static const int MaxDepth = 64;
+	// Subtrees with more primitives than this are built in parallel.
+	static const int ParallelBuildThreshold = 4096;
+	// Subtrees with more nodes than this are split up to be refitted in parallel.
+	static const int ParallelRefitThreshold = 2048;
+
+	// Relative costs used by the SAH.
+	static constexpr float TraversalCost = 1.0f;
+	static constexpr float IntersectionCost = 1.0f;
+
+protected:
+	struct BuildPrimitive
+	{
+		Box aabb;
+		vec3 centroid;
+		int index;
+	};
+
+	int buildRecursive(Array<BvhNode>& nodes, Array<BuildPrimitive>& primitives,
+		int begin, int end, int depth);
+	int createLeaf(Array<BvhNode>& nodes, const Box& aabb, int begin, int end);
+	// Partitions [begin, end) in place and returns the middle, or -1 if a leaf is better.
+	int splitSah(Array<BuildPrimitive>& primitives, int begin, int end,
+		const Box& aabb, const Box& centroidBounds, int& outAxis) const;
+	int splitMedian(Array<BuildPrimitive>& primitives, int begin, int end,
+		const Box& centroidBounds, int& outAxis) const;
+	void computeStats();
+
+	// Refits the nodes in [begin, end) from the last to the first. In the depth first order the
+	// children always come after their parent, so they are done first. Returns the SAH cost
+	// of the nodes, not yet divided by the area of the root.
+	float refitRange(const Array<Box>& aabbs, int begin, int end);
+	float refitNode(const Array<Box>& aabbs, int nodeIndex);
+
+	template <bool IsAnyHit, typename HitLeaf>
+	bool traverseLeavesImpl(const Ray& ray, float t_min, float t_max, HitLeaf&& hitLeaf) const;
+
+	// Slab test against the node bounds with a precomputed inverse ray direction.
+	static bool hitNode(const BvhNode& node, const vec3& origin, const vec3& invDirection,
+		float t_min, float t_max);
+
+	BvhBuildOptions m_options;
+	BvhStats m_stats;
+	float m_builtSahCost = 0.0f;
+
+	Array<BvhNode> m_nodes;
+	Array<int> m_primitiveIndices;
+};
+
+inline bool BvhTree::hitNode(const BvhNode& node, const vec3& origin, const vec3& invDirection,
+	float t_min, float t_max)
+{
+	for (int a = 0; a < 3; ++a)
+	{
+		float t0 = (node.min[a] - origin[a]) * invDirection[a];
+		float t1 = (node.max[a] - origin[a]) * invDirection[a];
+		if (invDirection[a] < 0.0f)
+			std::swap(t0, t1);
+		t_min = t0 > t_min ? t0 : t_min;
+		t_max = t1 < t_max ? t1 : t_max;
+		if (t_max < t_min)
+			return false;
+	}
+	return true;
+}
+
+template <typename HitPrimitive>
+bool BvhTree::traverse(const Ray& ray, float t_min, float t_max, HitPrimitive&& hitPrimitive) const
+{
+	return traverseLeaves(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
+	{
+		bool isHit = false;
+		for (int i = begin; i < end; ++i)
+		{
+			if (hitPrimitive(i, nearT, farT))
+				isHit = true;
+		}
+		return isHit;
+	});
+}
+
+template <typename HitLeaf>
+bool BvhTree::traverseLeaves(const Ray& ray, float t_min, float t_max, HitLeaf&& hitLeaf) const
+{
+	return traverseLeavesImpl<false>(ray, t_min, t_max, hitLeaf);
+}
+
+template <typename HitPrimitive>
+bool BvhTree::traverseAny(const Ray& ray, float t_min, float t_max, HitPrimitive&& hitPrimitive) const
+{
+	return traverseLeavesAny(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			if (hitPrimitive(i, nearT, farT))
+				return true;
+		}
+		return false;
+	});
+}
+
+template <typename HitLeaf>
+bool BvhTree::traverseLeavesAny(const Ray& ray, float t_min, float t_max, HitLeaf&& hitLeaf) const
+{
+	return traverseLeavesImpl<true>(ray, t_min, t_max, hitLeaf);
+}
+
+template <bool IsAnyHit, typename HitLeaf>
+bool BvhTree::traverseLeavesImpl(const Ray& ray, float t_min, float t_max, HitLeaf&& hitLeaf) const
+{
+	if (m_nodes.empty())
+		return false;
+
+	const vec3 origin = ray.origin();
+	const vec3 invDirection = 1.0f / ray.direction();
+	const bool directionIsNegative[3] =
+	{
+		invDirection.x < 0.0f,
+		invDirection.y < 0.0f,
+		invDirection.z < 0.0f
+	};
+
+	int stack[MaxDepth];
+	int stackSize = 0;
+	int nodeIndex = 0;
+	bool isHit = false;
+
+	while (true)
+	{
+		const BvhNode& node = m_nodes[nodeIndex];
+
+		RAE_COUNT_RAY_STAT(aabbTestCount, 1);
+		if (hitNode(node, origin, invDirection, t_min, t_max))
+		{
+			RAE_COUNT_RAY_STAT(bvhNodeCount, 1);
+			if (node.isLeaf())
+			{
+				if (hitLeaf(node.offset, node.offset + node.primitiveCount, t_min, t_max))
+				{
+					if (IsAnyHit)
+						return true;
+					isHit = true;
+				}
+			}
+			else
+			{
+				// Visit the near child first, so that t_max shrinks before the far child is tested.
+				if (directionIsNegative[node.axis])
+				{
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					nodeIndex = nodeIndex + 1;
+				}
+				continue;
+			}
+		}
+
+		if (stackSize == 0)
+			break;
+		nodeIndex = stack[--stackSize];
+	}
+
+	return isHit;
+}
+
+// Bvh over hitables. The hitables are not owned by the Bvh.
+class Bvh : public Hitable
+{
+public:
+	Bvh(){}
+	Bvh(const Array<Hitable*>& hitables, BvhSplitMethod splitMethod = BvhSplitMethod::Sah);
+
+	void build(const Array<Hitable*>& hitables, BvhSplitMethod splitMethod = BvhSplitMethod::Sah);
+	void clear();
+	// For when the same hitables have moved or changed size, like animated instances. Refits the
+	// tree, or rebuilds it when the refits have made the SAH cost grow more than maxSahCostGrowth
+	// times the cost after the last build. Returns true if it was rebuilt.
+	bool update(float maxSahCostGrowth = DefaultMaxSahCostGrowth);
+
+	bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const override;
+	bool occluded(const Ray& ray, float t_min, float t_max) const override;
+	Box getAabb(float t0, float t1) const override;
+
+	bool isEmpty() const { return m_tree.isEmpty(); }
+	int nodeCount() const { return m_tree.nodeCount(); }
+	int primitiveCount() const { return (int)m_primitives.size(); }
+	const BvhTree& tree() const { return m_tree; }
+	const BvhStats& stats() const { return m_tree.stats(); }
+
+	static constexpr float DefaultMaxSahCostGrowth = 1.5f;
+
+protected:
+	BvhTree m_tree;
+	BvhSplitMethod m_splitMethod = BvhSplitMethod::Sah;
+	Array<Hitable*> m_primitives; // In the order the leaves refer to them.
+};
+
+}
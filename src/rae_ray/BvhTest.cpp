@@ -0,0 +1,140 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Scenes.hpp"
+#include "rae_ray/Sphere.hpp"
+
+using namespace rae;
+
+// A ground sphere and a grid of small spheres like in the book scene, but without materials,
+// which the Bvh doesn't need.
+static void createSphereGrid(HitableList& world, int gridSize)
+{
+	world.add(new Sphere(vec3(0, -1000, 0), 1000, nullptr));
+
+	for (int a = -gridSize; a < gridSize; a++)
+	{
+		for (int b = -gridSize; b < gridSize; b++)
+		{
+			vec3 center(a + 0.9f * getRandom(), 0.2f, b + 0.9f * getRandom());
+			world.add(new Sphere(center, 0.2f, nullptr));
+		}
+	}
+}
+
+// Returns how many of the random rays hit something different in the tree than in the list.
+static int countMismatches(const Bvh& tree, const HitableList& world, float extent, int rayCount, int& outHits)
+{
+	int mismatches = 0;
+	outHits = 0;
+	for (int i = 0; i < rayCount; ++i)
+	{
+		vec3 origin(getRandom(-extent, extent), getRandom(0.1f, 5.0f), getRandom(-extent, extent));
+		vec3 direction(getRandom(-1.0f, 1.0f), getRandom(-1.0f, 0.5f), getRandom(-1.0f, 1.0f));
+		Ray ray(origin, direction);
+
+		HitRecord treeRecord;
+		HitRecord listRecord;
+		bool treeHit = tree.hit(ray, 0.001f, FLT_MAX, treeRecord);
+		bool listHit = world.hit(ray, 0.001f, FLT_MAX, listRecord);
+
+		// Also as a shadow ray, which is blocked by anything, but only before the closest hit.
+		if (treeHit != listHit
+			|| (treeHit && treeRecord.t != listRecord.t)
+			|| tree.occluded(ray, 0.001f, FLT_MAX) != listHit
+			|| (listHit && tree.occluded(ray, 0.001f, 0.99f * listRecord.t)))
+		{
+			mismatches++;
+		}
+		if (treeHit)
+			outHits++;
+	}
+	return mismatches;
+}
+
+SCENARIO("Bvh unittest", "[rae][Bvh]")
+{
+	GIVEN( "a grid of spheres like in the book scene" )
+	{
+		HitableList world;
+		createSphereGrid(world, /*gridSize*/11);
+
+		for (auto splitMethod : { BvhSplitMethod::Median, BvhSplitMethod::Sah })
+		{
+			Bvh tree(world.list(), splitMethod);
+
+			REQUIRE(tree.primitiveCount() == (int)world.list().size());
+			REQUIRE(tree.nodeCount() < 2 * tree.primitiveCount());
+			REQUIRE(tree.stats().nodeCount == tree.nodeCount());
+			REQUIRE(tree.stats().leafCount == (tree.nodeCount() + 1) / 2);
+			REQUIRE(tree.stats().maxDepth < BvhTree::MaxDepth);
+			REQUIRE(tree.stats().sahCost > 0.0f);
+
+			int hits = 0;
+			int mismatches = countMismatches(tree, world, 15.0f, 2000, hits);
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+		}
+	}
+
+	GIVEN( "a scene big enough to build subtrees in parallel" )
+	{
+		HitableList world;
+		Camera camera;
+		createSphereGrid(world, /*gridSize*/40);
+		REQUIRE((int)world.list().size() > BvhTree::ParallelBuildThreshold);
+
+		Bvh medianTree(world.list(), BvhSplitMethod::Median);
+		Bvh sahTree(world.list(), BvhSplitMethod::Sah);
+
+		THEN( "the SAH tree is cheaper and rays hit the same things as when testing every object" )
+		{
+			REQUIRE(sahTree.stats().sahCost < medianTree.stats().sahCost);
+
+			int hits = 0;
+			int mismatches = countMismatches(sahTree, world, 40.0f, 2000, hits);
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+		}
+
+		THEN( "small moves are refitted in parallel subtrees, and big ones rebuild the tree" )
+		{
+			REQUIRE(sahTree.nodeCount() > BvhTree::ParallelRefitThreshold);
+
+			// Skips the ground sphere.
+			for (int i = 1; i < (int)world.list().size(); ++i)
+			{
+				static_cast<Sphere*>(world.list()[i])->center += vec3(getRandom(-0.1f, 0.1f), getRandom(0.0f, 0.2f), getRandom(-0.1f, 0.1f));
+			}
+			REQUIRE(sahTree.update() == false);
+			REQUIRE(sahTree.stats().sahCost < Bvh::DefaultMaxSahCostGrowth * sahTree.tree().builtSahCost());
+
+			int hits = 0;
+			int mismatches = countMismatches(sahTree, world, 40.0f, 2000, hits);
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+
+			// Scattered all over, so the old nodes would overlap a lot.
+			for (int i = 1; i < (int)world.list().size(); ++i)
+			{
+				static_cast<Sphere*>(world.list()[i])->center = vec3(getRandom(-40.0f, 40.0f), 0.2f, getRandom(-40.0f, 40.0f));
+			}
+			REQUIRE(sahTree.update() == true);
+			REQUIRE(sahTree.stats().sahCost == sahTree.tree().builtSahCost());
+
+			mismatches = countMismatches(sahTree, world, 40.0f, 2000, hits);
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,189 @@
+#include "rae_ray/Denoiser.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#include "rae/core/Utils.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+
+using namespace rae;
+
+const int Denoiser::TileSize;
+
+// Below this the albedo isn't divided out, to not blow up the noise of dark materials.
+static const float MinAlbedo = 0.01f;
+
+void Denoiser::denoise(const AccumulationBuffer& input, Array<vec3>& output)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_width = input.width();
+	m_height = input.height();
+	const int pixelCount = m_width * m_height;
+	m_albedo.resize(pixelCount);
+	m_guides.resize(pixelCount);
+	m_signal.resize(pixelCount);
+	m_filtered.resize(pixelCount);
+
+	parallel_for(0, m_height, [&](int y)
+	{
+		for (int x = 0; x < m_width; ++x)
+		{
+			const int i = y * m_width + x;
+			const vec3 albedo = glm::max(input.albedo(x, y), vec3(MinAlbedo, MinAlbedo, MinAlbedo));
+			const vec3 normal = input.normal(x, y);
+			const float normalLength = glm::length(normal);
+
+			m_albedo[i] = albedo;
+			m_guides[i].normal = normalLength > 0.0f ? normal / normalLength : normal;
+			m_guides[i].depth = input.depth(x, y);
+			m_signal[i].irradiance = input.color(x, y) / albedo;
+
+			// With a single sample, guess that the noise is as large as the value.
+			float error = input.standardError(x, y);
+			if (error == FLT_MAX)
+				error = luminance(input.color(x, y));
+			error /= luminance(albedo);
+			m_signal[i].variance = error * error;
+		}
+	});
+
+	for (int iteration = 0; iteration < m_iterations; ++iteration)
+	{
+		filterIteration(1 << iteration);
+		m_signal.swap(m_filtered);
+	}
+
+	output.resize(pixelCount);
+	for (int i = 0; i < pixelCount; ++i)
+	{
+		output[i] = m_signal[i].irradiance * m_albedo[i];
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	m_lastTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// The variance estimate of a few samples is noisy itself: with eight samples, a pixel may
+// have missed the light every time and look like it has no noise at all.
+float Denoiser::blurredVariance(int x, int y) const
+{
+	static const float Kernel[2] = { 1.0f / 2.0f, 1.0f / 4.0f };
+
+	float sum = 0.0f;
+	float weightSum = 0.0f;
+	for (int dy = -1; dy <= 1; ++dy)
+	{
+		const int sampleY = y + dy;
+		if (sampleY < 0 || sampleY >= m_height)
+			continue;
+
+		for (int dx = -1; dx <= 1; ++dx)
+		{
+			const int sampleX = x + dx;
+			if (sampleX < 0 || sampleX >= m_width)
+				continue;
+
+			const float weight = Kernel[std::abs(dx)] * Kernel[std::abs(dy)];
+			sum += m_signal[sampleY * m_width + sampleX].variance * weight;
+			weightSum += weight;
+		}
+	}
+	return sum / weightSum;
+}
+
+// Much faster than std::pow, which matters in the inner loop.
+static float integerPower(float value, int power)
+{
+	float result = 1.0f;
+	for (; power > 0; power >>= 1)
+	{
+		if (power & 1)
+			result *= value;
+		value *= value;
+	}
+	return result;
+}
+
+void Denoiser::filterIteration(int step)
+{
+	static const float Kernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f }; // B3 spline
+
+	const int tilesX = (m_width + TileSize - 1) / TileSize;
+	const int tilesY = (m_height + TileSize - 1) / TileSize;
+
+	parallel_for(0, tilesX * tilesY, [&](int tile)
+	{
+		const int beginX = (tile % tilesX) * TileSize;
+		const int beginY = (tile / tilesX) * TileSize;
+		const int endX = std::min(beginX + TileSize, m_width);
+		const int endY = std::min(beginY + TileSize, m_height);
+
+		for (int y = beginY; y < endY; ++y)
+		{
+			for (int x = beginX; x < endX; ++x)
+			{
+				const int center = y * m_width + x;
+				const float centerLuminance = luminance(m_signal[center].irradiance);
+				// Differences smaller than the noise get blurred, larger ones are edges.
+				const float colorFactor = 1.0f / (m_colorSigma * std::sqrt(blurredVariance(x, y)) + 0.0001f);
+				const vec3 centerNormal = m_guides[center].normal;
+				const float centerDepth = m_guides[center].depth;
+				const bool isCenterHit = centerDepth > 0.0f;
+				const float depthFactor = isCenterHit ? 1.0f / (m_depthSigma * centerDepth * step) : 0.0f;
+
+				vec3 sum(0.0f, 0.0f, 0.0f);
+				float weightSum = 0.0f;
+				float varianceSum = 0.0f;
+
+				for (int dy = -2; dy <= 2; ++dy)
+				{
+					const int sampleY = y + dy * step;
+					if (sampleY < 0 || sampleY >= m_height)
+						continue;
+
+					for (int dx = -2; dx <= 2; ++dx)
+					{
+						const int sampleX = x + dx * step;
+						if (sampleX < 0 || sampleX >= m_width)
+							continue;
+
+						const Guide& guide = m_guides[sampleY * m_width + sampleX];
+						const Signal& signal = m_signal[sampleY * m_width + sampleX];
+						const bool isHit = guide.depth > 0.0f;
+						if (isHit != isCenterHit)
+							continue; // Never mix the sky with the objects.
+
+						// The color and depth edge stopping functions as one exponential.
+						float normalWeight = 1.0f;
+						float exponent = -std::abs(luminance(signal.irradiance) - centerLuminance) * colorFactor;
+						if (isHit)
+						{
+							const float cosine = glm::dot(guide.normal, centerNormal);
+							if (cosine <= 0.0f)
+								continue;
+							exponent -= std::abs(guide.depth - centerDepth) * depthFactor;
+							normalWeight = integerPower(cosine, m_normalPower);
+						}
+						const float weight = Kernel[std::abs(dx)] * Kernel[std::abs(dy)] * normalWeight * std::exp(exponent);
+
+						sum += signal.irradiance * weight;
+						weightSum += weight;
+						varianceSum += signal.variance * weight * weight;
+					}
+				}
+
+				// The center always has a weight, unless its normal is degenerate.
+				if (weightSum > 0.0f)
+				{
+					m_filtered[center].irradiance = sum / weightSum;
+					// The noise left after averaging, to guide the next iteration.
+					m_filtered[center].variance = varianceSum / (weightSum * weightSum);
+				}
+				else m_filtered[center] = m_signal[center];
+			}
+		}
+	}, /*grainSize*/1);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+class AccumulationBuffer;
+
+// Edge avoiding a-trous wavelet filter (Dammertz et al. 2010, "Edge-Avoiding A-Trous Wavelet
+// Transform for fast Global Illumination Filtering"). Blurs the noise away with a growing
+// 5x5 kernel, but not across edges in the normals, depth or colors. Like in SVGF (Schied et
+// al. 2017), a color edge is a difference larger than the noise estimated from the variance
+// of the samples. The albedo is divided out before filtering and multiplied back after, so
+// textures stay sharp.
+class Denoiser
+{
+public:
+	static const int TileSize = 32;
+
+	// Writes the denoised colors of the buffer to output, row by row.
+	void denoise(const AccumulationBuffer& input, Array<vec3>& output);
+
+	// Each iteration doubles the reach of the kernel: 5 iterations cover 125 pixels.
+	void setIterations(int iterations) { m_iterations = iterations; }
+	int iterations() const { return m_iterations; }
+	// In standard deviations of the noise. Smaller values keep more detail, and more noise.
+	void setColorSigma(float sigma) { m_colorSigma = sigma; }
+	// The power of the cosine between the normals. Larger values keep sharper corners.
+	void setNormalPower(int power) { m_normalPower = power; }
+	void setDepthSigma(float sigma) { m_depthSigma = sigma; }
+
+	// How long the last denoise() took.
+	double lastTimeMs() const { return m_lastTimeMs; }
+
+protected:
+	void filterIteration(int step);
+	float blurredVariance(int x, int y) const;
+
+	int m_iterations = 5;
+	float m_colorSigma = 4.0f;
+	int m_normalPower = 64;
+	float m_depthSigma = 0.05f; // Relative to the depth.
+
+	double m_lastTimeMs = 0.0;
+
+	// What a filter tap reads of a pixel, packed in two arrays instead of five.
+	struct Guide
+	{
+		vec3 normal;
+		float depth; // Zero for the sky.
+	};
+	struct Signal
+	{
+		vec3 irradiance; // The color with the albedo divided out.
+		float variance; // Of the luminance of the irradiance.
+	};
+
+	int m_width = 0;
+	int m_height = 0;
+	Array<vec3> m_albedo;
+	Array<Guide> m_guides;
+	Array<Signal> m_signal;
+	Array<Signal> m_filtered;
+};
+
+}
@@ -0,0 +1,78 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cmath>
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/Denoiser.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/ReferenceRender.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/Scenes.hpp"
+
+using namespace rae;
+
+SCENARIO("Denoiser unittest", "[rae][Denoiser]")
+{
+	GIVEN( "a noisy image of two walls meeting in the middle" )
+	{
+		const int width = 64;
+		const int height = 32;
+		const vec3 leftColor(0.2f, 0.2f, 0.2f);
+		const vec3 rightColor(0.8f, 0.8f, 0.8f);
+
+		AccumulationBuffer buffer;
+		buffer.init(width, height);
+		Array<vec3> reference;
+
+		seedThreadRandom(/*seed*/3, 0, 0);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const bool isLeft = x < width / 2;
+				FirstHit firstHit;
+				firstHit.albedo = vec3(0.5f, 0.5f, 0.5f);
+				firstHit.normal = isLeft ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+				firstHit.depth = 5.0f;
+
+				const vec3 color = isLeft ? leftColor : rightColor;
+				for (int sample = 0; sample < 8; ++sample)
+				{
+					// Every other sample finds the light.
+					buffer.addSample(x, y, color * (getRandom() < 0.5f ? 0.0f : 2.0f), firstHit);
+				}
+				reference.push_back(color);
+			}
+		}
+
+		Denoiser denoiser;
+		Array<vec3> denoised;
+		denoiser.denoise(buffer, denoised);
+
+		THEN( "the noise is mostly gone" )
+		{
+			REQUIRE(denoised.size() == reference.size());
+			const double noisyError = rootMeanSquareError(bufferColors(buffer), reference, /*maxValue*/1.0f);
+			const double denoisedError = rootMeanSquareError(denoised, reference, /*maxValue*/1.0f);
+			REQUIRE(denoisedError < 0.25 * noisyError);
+		}
+
+		THEN( "the edge stays sharp" )
+		{
+			for (int y = 0; y < height; ++y)
+			{
+				REQUIRE(std::abs(denoised[y * width + width / 2 - 1].r - leftColor.r) < 0.1f);
+				REQUIRE(std::abs(denoised[y * width + width / 2].r - rightColor.r) < 0.1f);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "rae_ray/EntityScene.hpp"
+
+#include <algorithm>
+
+#include "rae/visual/Material.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae/visual/Transform.hpp"
+
+using namespace rae;
+
+bool EntityScene::findAssets(const EntityTables& tables, Id entity, Id& outMesh, Id& outMaterial) const
+{
+	if (tables.transforms->check(entity) == false || tables.meshLinks->check(entity) == false)
+		return false;
+
+	outMesh = tables.meshLinks->get(entity);
+	if (tables.meshes->check(outMesh) == false || tables.meshes->get(outMesh).triangleCount() == 0)
+		return false;
+
+	if (tables.materials->check(entity))
+		outMaterial = entity;
+	else if (tables.materialLinks->check(entity))
+		outMaterial = tables.materialLinks->get(entity);
+	else return false;
+
+	return tables.materials->check(outMaterial);
+}
+
+bool EntityScene::isChanged(const EntityTables& tables, const EntityInstance& mirrored, Id mesh, Id material) const
+{
+	const Id entity = mirrored.entity;
+	return mirrored.mesh != mesh
+		|| mirrored.material != material
+		|| tables.transforms->isUpdated(entity)
+		|| tables.meshLinks->isUpdated(entity)
+		|| tables.materialLinks->isUpdated(entity)
+		|| tables.meshes->isUpdated(mesh)
+		|| tables.materials->isUpdated(material);
+}
+
+bool EntityScene::isSyncNeeded(const EntityTables& tables) const
+{
+	bool isNeeded = false;
+	int renderableCount = 0;
+	query<Id>(*tables.meshLinks, [&](Id entity)
+	{
+		Id mesh;
+		Id material;
+		if (isNeeded || findAssets(tables, entity, mesh, material) == false)
+			return;
+
+		renderableCount++;
+		const int index = entity < (Id)m_instanceIndices.size() ? m_instanceIndices[entity] : InvalidIndex;
+		if (index == InvalidIndex || isChanged(tables, m_instances[index], mesh, material))
+			isNeeded = true;
+	});
+	// Removed entities are just missing.
+	return isNeeded || renderableCount != (int)m_instances.size();
+}
+
+EntitySyncStats EntityScene::sync(const EntityTables& tables)
+{
+	EntitySyncStats stats;
+	m_copiedMeshes.clear();
+
+	Array<bool_t> isSeen(m_instances.size(), false);
+	query<Id>(*tables.meshLinks, [&](Id entity)
+	{
+		Id mesh;
+		Id material;
+		if (findAssets(tables, entity, mesh, material) == false)
+			return;
+
+		if (entity >= (Id)m_instanceIndices.size())
+			m_instanceIndices.resize(entity + 1, InvalidIndex);
+
+		const int index = m_instanceIndices[entity];
+		if (index == InvalidIndex)
+		{
+			EntityInstance mirrored;
+			mirrored.entity = entity;
+			mirrored.mesh = mesh;
+			mirrored.material = material;
+			mirrored.instance.reset(new Instance(meshCopy(tables, mesh), Instance::toMatrix(tables.transforms->get(entity)),
+				materialFor(tables.materials->get(material))));
+			m_instanceIndices[entity] = (int)m_instances.size();
+			m_instances.push_back(std::move(mirrored));
+			isSeen.push_back(true);
+			stats.addedCount++;
+			return;
+		}
+
+		isSeen[index] = true;
+		EntityInstance& mirrored = m_instances[index];
+		if (isChanged(tables, mirrored, mesh, material) == false)
+			return;
+
+		if (mirrored.mesh != mesh || tables.meshes->isUpdated(mesh))
+		{
+			mirrored.mesh = mesh;
+			mirrored.instance.reset(new Instance(meshCopy(tables, mesh), Instance::toMatrix(tables.transforms->get(entity))));
+			stats.replacedCount++;
+		}
+		// Also for a changed mesh, as the box of the instance depends on it.
+		else mirrored.instance->setTransform(tables.transforms->get(entity));
+
+		mirrored.material = material;
+		mirrored.instance->setMaterial(materialFor(tables.materials->get(material)));
+		stats.updatedCount++;
+	});
+
+	// Fill the holes of the removed entities from the end.
+	for (int index = (int)m_instances.size() - 1; index >= 0; --index)
+	{
+		if (isSeen[index])
+			continue;
+
+		m_instanceIndices[m_instances[index].entity] = InvalidIndex;
+		if (index != (int)m_instances.size() - 1)
+		{
+			m_instances[index] = std::move(m_instances.back());
+			m_instanceIndices[m_instances[index].entity] = index;
+		}
+		m_instances.pop_back();
+		stats.removedCount++;
+	}
+
+	if (stats.isRebuildNeeded())
+	{
+		m_hitables.clear();
+		for (const EntityInstance& mirrored : m_instances)
+		{
+			m_hitables.push_back(mirrored.instance.get());
+		}
+	}
+
+	if (stats.isChanged())
+	{
+		// The meshes and the materials that no instance uses anymore.
+		for (auto it = m_meshes.begin(); it != m_meshes.end();)
+		{
+			it = it->second.use_count() == 1 ? m_meshes.erase(it) : std::next(it);
+		}
+		for (auto it = m_materials.begin(); it != m_materials.end();)
+		{
+			it = it->second.use_count() == 1 ? m_materials.erase(it) : std::next(it);
+		}
+	}
+
+	return stats;
+}
+
+void EntityScene::clear()
+{
+	m_hitables.clear();
+	m_instances.clear();
+	m_instanceIndices.clear();
+	m_meshes.clear();
+	m_materials.clear();
+}
+
+std::shared_ptr<Mesh> EntityScene::meshCopy(const EntityTables& tables, Id mesh)
+{
+	std::shared_ptr<Mesh>& copy = m_meshes[mesh];
+	const bool isCopied = std::find(m_copiedMeshes.begin(), m_copiedMeshes.end(), mesh) != m_copiedMeshes.end();
+	if (copy == nullptr || (tables.meshes->isUpdated(mesh) && isCopied == false))
+	{
+		// A new one, as the old one can be in the instances that haven't been synced yet.
+		copy = std::make_shared<Mesh>();
+		copy->copyGeometry(tables.meshes->get(mesh));
+		m_copiedMeshes.push_back(mesh);
+	}
+	return copy;
+}
+
+std::shared_ptr<Material> EntityScene::materialFor(const Material& material)
+{
+	const Color3 color = material.color3();
+	std::shared_ptr<Material>& tracerMaterial = m_materials[std::make_tuple(color.r, color.g, color.b)];
+	if (tracerMaterial == nullptr)
+		tracerMaterial = std::make_shared<Lambertian>(color);
+	return tracerMaterial;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "rae/core/Types.hpp"
+#include "rae/entity/Table.hpp"
+#include "rae_ray/Instance.hpp"
+
+namespace rae
+{
+
+struct Transform;
+class Mesh;
+class Material;
+
+// The tables the renderable entities are in. Like in the RenderSystem, an entity is renderable
+// when it has a transform, a mesh link and either a material of its own or a material link.
+struct EntityTables
+{
+	const Table<Transform>* transforms = nullptr;
+	const Table<Id>* meshLinks = nullptr; // From the entities to the mesh assets.
+	const Table<Id>* materialLinks = nullptr; // From the entities to the material assets.
+	const Table<Mesh>* meshes = nullptr;
+	const Table<Material>* materials = nullptr; // The material assets and the materials of the entities.
+
+	bool isValid() const
+	{
+		return transforms && meshLinks && materialLinks && meshes && materials;
+	}
+};
+
+struct EntitySyncStats
+{
+	int addedCount = 0;
+	int updatedCount = 0;
+	int removedCount = 0;
+	int replacedCount = 0; // Of the updated ones, those that got a new instance for a new mesh.
+
+	bool isChanged() const { return addedCount + updatedCount + removedCount > 0; }
+	// Otherwise the same instances have only moved, and the top level Bvh can be refitted.
+	bool isRebuildNeeded() const { return addedCount + removedCount + replacedCount > 0; }
+};
+
+// Mirrors the renderable entities as Instances for the top level Bvh of the ray tracer. Each mesh
+// asset is copied once, with its own Bvh, and shared by the instances of all the entities that
+// use it. A sync only touches the entities that were added, removed or updated in their tables
+// since the last one, so moving an entity changes its instance and the top level, not the meshes.
+class EntityScene
+{
+public:
+	// True if the tables have changed since the last sync. Cheap enough for every frame.
+	bool isSyncNeeded(const EntityTables& tables) const;
+	EntitySyncStats sync(const EntityTables& tables);
+	void clear();
+
+	// For building the top level Bvh. Changes in sync when a rebuild is needed.
+	const Array<Hitable*>& hitables() const { return m_hitables; }
+	int instanceCount() const { return (int)m_instances.size(); }
+	int meshCount() const { return (int)m_meshes.size(); }
+
+protected:
+	struct EntityInstance
+	{
+		Id entity;
+		Id mesh;
+		Id material;
+		std::unique_ptr<Instance> instance;
+	};
+
+	// The mesh and the material of a renderable entity, or false if it isn't one.
+	bool findAssets(const EntityTables& tables, Id entity, Id& outMesh, Id& outMaterial) const;
+	bool isChanged(const EntityTables& tables, const EntityInstance& mirrored, Id mesh, Id material) const;
+	std::shared_ptr<Mesh> meshCopy(const EntityTables& tables, Id mesh);
+	// The tracer materials are Lambertians with the color of the entity material, one per color.
+	std::shared_ptr<Material> materialFor(const Material& material);
+
+	Array<EntityInstance> m_instances;
+	Array<int> m_instanceIndices; // By entity, InvalidIndex for the ones not mirrored.
+	Array<Hitable*> m_hitables; // The instances, in the same order.
+
+	std::map<Id, std::shared_ptr<Mesh>> m_meshes;
+	Array<Id> m_copiedMeshes; // During a sync, so that each updated mesh is copied once.
+	std::map<std::tuple<float, float, float>, std::shared_ptr<Material>> m_materials;
+};
+
+}
@@ -0,0 +1,109 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cfloat>
+
+#include "rae/entity/Table.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae/visual/Transform.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/EntityScene.hpp"
+#include "rae_ray/HitRecord.hpp"
+
+using namespace rae;
+
+SCENARIO("EntityScene unittest", "[rae][EntityScene]")
+{
+	GIVEN( "three box entities sharing a mesh and a material, one of them with a material of its own" )
+	{
+		Table<Transform> transforms;
+		Table<Id> meshLinks;
+		Table<Id> materialLinks;
+		Table<Mesh> meshes;
+		Table<Material> materials;
+
+		EntityTables tables;
+		tables.transforms = &transforms;
+		tables.meshLinks = &meshLinks;
+		tables.materialLinks = &materialLinks;
+		tables.meshes = &meshes;
+		tables.materials = &materials;
+
+		const Id boxMesh = 1;
+		const Id blueMaterial = 2;
+		Mesh box;
+		box.generateBox();
+		meshes.assign(boxMesh, std::move(box));
+		materials.assign(blueMaterial, Material(Color3(0.2f, 0.5f, 0.7f)));
+
+		for (Id entity = 3; entity <= 5; ++entity)
+		{
+			transforms.assign(entity, Transform(vec3(0.0f, 0.0f, 4.0f * entity)));
+			meshLinks.assign(entity, Id(boxMesh));
+			materialLinks.assign(entity, Id(blueMaterial));
+		}
+		materials.assign(5, Material(Color3(0.7f, 0.3f, 0.1f)));
+
+		EntityScene scene;
+		REQUIRE(scene.isSyncNeeded(tables));
+		EntitySyncStats stats = scene.sync(tables);
+		REQUIRE(stats.addedCount == 3);
+		REQUIRE(scene.instanceCount() == 3);
+		REQUIRE(scene.meshCount() == 1);
+
+		auto clearUpdated = [&]()
+		{
+			transforms.clearUpdated();
+			meshLinks.clearUpdated();
+			materialLinks.clearUpdated();
+			meshes.clearUpdated();
+			materials.clearUpdated();
+		};
+		clearUpdated();
+
+		THEN( "nothing is synced until something changes" )
+		{
+			REQUIRE(scene.isSyncNeeded(tables) == false);
+			REQUIRE(scene.sync(tables).isChanged() == false);
+		}
+
+		THEN( "only a moved entity is updated, and found in its new place" )
+		{
+			transforms.getF(4).position = vec3(10.0f, 0.0f, 0.0f);
+			transforms.setUpdated(4);
+			REQUIRE(scene.isSyncNeeded(tables));
+
+			stats = scene.sync(tables);
+			REQUIRE(stats.addedCount == 0);
+			REQUIRE(stats.updatedCount == 1);
+			REQUIRE(stats.removedCount == 0);
+
+			Bvh tree(scene.hitables());
+			HitRecord record;
+			REQUIRE(tree.hit(Ray(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f)), 0.001f, FLT_MAX, record));
+			REQUIRE(record.t == Approx(9.5f));
+		}
+
+		THEN( "a removed entity is dropped, and mirrored again when it comes back" )
+		{
+			meshLinks.remove(5);
+			REQUIRE(scene.isSyncNeeded(tables));
+
+			stats = scene.sync(tables);
+			REQUIRE(stats.removedCount == 1);
+			REQUIRE(scene.instanceCount() == 2);
+			REQUIRE(scene.hitables().size() == 2);
+
+			meshLinks.assign(5, Id(boxMesh));
+			stats = scene.sync(tables);
+			REQUIRE(stats.addedCount == 1);
+			REQUIRE(scene.instanceCount() == 3);
+		}
+	}
+}
+
+#endif
@@ -12,6 +12,8 @@ struct HitRecord
 	vec3 point;
 	vec3 normal;
 	Material* material = nullptr;
+	// Into the MaterialTable the hitable was bound to, or -1 if it wasn't.
+	int materialIndex = -1;
 };
 
 }
@@ -0,0 +1,12 @@
+#include "rae_ray/Hitable.hpp"
+
+#include "rae/core/Types.hpp"
+#include "rae_ray/HitRecord.hpp"
+
+using namespace rae;
+
+bool Hitable::occluded(const Ray& ray, float t_min, float t_max) const
+{
+	HitRecord record;
+	return hit(ray, t_min, t_max, record);
+}
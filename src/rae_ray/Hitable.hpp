@@ -6,6 +6,7 @@ namespace rae
 class Ray;
 struct HitRecord;
 class Box;
+class MaterialTable;
 
 class Hitable
 {
@@ -15,7 +16,16 @@ public:
 	virtual ~Hitable(){}
 
 	virtual bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const = 0;
+	// True if anything is hit between t_min and t_max. For shadow rays, which don't need the
+	// closest hit. The default just calls hit().
+	virtual bool occluded(const Ray& ray, float t_min, float t_max) const;
 	virtual Box getAabb(float t0, float t1) const = 0;
+	// Adds the materials to the table and keeps their indices for the hits. Call again after
+	// the table is cleared. The hitables without materials have nothing to do.
+	virtual void bindMaterials(MaterialTable& /*table*/) {}
+	// Builds the trees of its own that hit() would otherwise build on the first ray, like the
+	// triangle tree of a Mesh. Does nothing for the ones that are already built.
+	virtual void buildTrees() const {}
 };
 
 }
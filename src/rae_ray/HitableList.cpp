@@ -22,6 +22,16 @@ bool HitableList::hit(const Ray& ray, float t_min, float t_max, HitRecord& recor
 	return hitAnything;
 }
 
+bool HitableList::occluded(const Ray& ray, float t_min, float t_max) const
+{
+	for (size_t i = 0; i < m_list.size(); ++i)
+	{
+		if (m_list[i]->occluded(ray, t_min, t_max))
+			return true;
+	}
+	return false;
+}
+
 Box HitableList::getAabb(float t0, float t1) const
 {
 	return Box();
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <stddef.h>
 #include <vector>
 #include "Hitable.hpp"
+#include "rae_ray/SceneArena.hpp"
 
 namespace rae
 {
@@ -9,6 +11,9 @@ namespace rae
 class Ray;
 struct HitRecord;
 
+// A list of hitables that also owns them. The scenes create their hitables and the materials
+// those share in the arena of the list, so clear() releases a whole scene at once and the next
+// scene reuses the memory.
 class HitableList : public Hitable
 {
 public:
@@ -24,25 +29,49 @@ public:
 
 	void clear()
 	{
-		for(size_t i = 0; i < m_list.size(); ++i)
+		for (Hitable* hitable : m_heapHitables)
 		{
-			delete m_list[i];
+			delete hitable;
 		}
+		m_heapHitables.clear();
 		m_list.clear();
+		m_arena.clear();
 	}
 
 	virtual bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const;
+	virtual bool occluded(const Ray& ray, float t_min, float t_max) const;
 	virtual Box getAabb(float t0, float t1) const;
 
+	// Takes ownership of a hitable allocated with new.
 	void add(Hitable* hitable)
 	{
 		m_list.push_back(hitable);
+		m_heapHitables.push_back(hitable);
+	}
+
+	// A hitable in the arena, added to the list.
+	template <typename T, typename... Args>
+	T* create(Args&&... args)
+	{
+		T* hitable = m_arena.create<T>(std::forward<Args>(args)...);
+		m_list.push_back(hitable);
+		return hitable;
+	}
+
+	// A material in the arena, for any number of the hitables to share until clear().
+	template <typename T, typename... Args>
+	T* createMaterial(Args&&... args)
+	{
+		return m_arena.create<T>(std::forward<Args>(args)...);
 	}
 
 	std::vector<Hitable*>& list() { return m_list; }
+	const SceneArena& arena() const { return m_arena; }
 
 protected:
 	std::vector<Hitable*> m_list;
+	std::vector<Hitable*> m_heapHitables;
+	SceneArena m_arena;
 };
 
 }
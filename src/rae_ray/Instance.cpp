@@ -0,0 +1,86 @@
+#include "rae_ray/Instance.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "rae/visual/Ray.hpp"
+#include "rae/visual/Transform.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/MaterialTable.hpp"
+
+using namespace rae;
+
+Instance::Instance(std::shared_ptr<const Hitable> object, const mat4& transform,
+	std::shared_ptr<Material> material) :
+	m_object(std::move(object)),
+	m_material(std::move(material))
+{
+	setTransform(transform);
+}
+
+mat4 Instance::toMatrix(const Transform& transform)
+{
+	// The same as the model matrix of the RenderSystem.
+	return glm::translate(mat4(1.0f), transform.position)
+		* glm::toMat4(transform.rotation)
+		* glm::scale(mat4(1.0f), transform.scale);
+}
+
+void Instance::setTransform(const Transform& transform)
+{
+	setTransform(toMatrix(transform));
+}
+
+void Instance::setTransform(const mat4& transform)
+{
+	m_transform = transform;
+	m_inverse = glm::inverse(transform);
+	m_normalMatrix = glm::transpose(glm::mat3(m_inverse));
+
+	// The box around the corners of the object box.
+	m_aabb.clear();
+	const Box objectAabb = m_object->getAabb(0.0f, 0.0f);
+	if (objectAabb.valid() == false)
+		return;
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		const vec3 point(
+			(corner & 1) ? objectAabb.max().x : objectAabb.min().x,
+			(corner & 2) ? objectAabb.max().y : objectAabb.min().y,
+			(corner & 4) ? objectAabb.max().z : objectAabb.min().z);
+		m_aabb.grow(vec3(transform * vec4(point, 1.0f)));
+	}
+}
+
+Ray Instance::toObjectSpace(const Ray& ray) const
+{
+	// The direction isn't normalized, so the distances along the ray stay the same in both spaces.
+	return Ray(vec3(m_inverse * vec4(ray.origin(), 1.0f)), glm::mat3(m_inverse) * ray.direction());
+}
+
+bool Instance::hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const
+{
+	if (m_object->hit(toObjectSpace(ray), t_min, t_max, record) == false)
+		return false;
+
+	record.point = ray.pointAtParameter(record.t);
+	record.normal = glm::normalize(m_normalMatrix * record.normal);
+	if (m_material)
+	{
+		record.material = m_material.get();
+		record.materialIndex = m_materialIndex;
+	}
+	else record.materialIndex = -1; // The object wasn't bound to the table of this scene.
+	return true;
+}
+
+bool Instance::occluded(const Ray& ray, float t_min, float t_max) const
+{
+	return m_object->occluded(toObjectSpace(ray), t_min, t_max);
+}
+
+void Instance::bindMaterials(MaterialTable& table)
+{
+	m_materialIndex = m_material ? table.add(*m_material) : -1;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+
+#include "rae/core/Types.hpp"
+#include "rae/visual/Box.hpp"
+#include "rae_ray/Hitable.hpp"
+
+namespace rae
+{
+
+class Material;
+struct Transform;
+
+// A placed copy of an object, for the top level of a two level Bvh. The object, usually a Mesh
+// or a SphereSet with its own tree, is shared by all its instances and stays in its own space.
+// Rays are moved into that space when they reach the instance, so a thousand bunnies cost a
+// thousand Instances and one mesh, and moving one only changes its box in the top level.
+class Instance : public Hitable
+{
+public:
+	Instance(std::shared_ptr<const Hitable> object, const mat4& transform = mat4(1.0f),
+		std::shared_ptr<Material> material = nullptr);
+
+	bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const override;
+	bool occluded(const Ray& ray, float t_min, float t_max) const override;
+	Box getAabb(float t0, float t1) const override { return m_aabb; }
+	// Only the material of the instance. The object can be shared by scenes with other tables.
+	void bindMaterials(MaterialTable& table) override;
+	void buildTrees() const override { m_object->buildTrees(); }
+
+	// Rebuild the Bvh that has the instance after these.
+	void setTransform(const mat4& transform);
+	void setTransform(const Transform& transform);
+	const mat4& transform() const { return m_transform; }
+
+	const std::shared_ptr<const Hitable>& object() const { return m_object; }
+	// Replaces the material of the object on this instance, if not null. Can be shared with other instances.
+	const std::shared_ptr<Material>& material() const { return m_material; }
+	// Bind again after this.
+	void setMaterial(std::shared_ptr<Material> material)
+	{
+		m_material = std::move(material);
+		m_materialIndex = -1;
+	}
+
+	static mat4 toMatrix(const Transform& transform);
+
+protected:
+	Ray toObjectSpace(const Ray& ray) const;
+
+	std::shared_ptr<const Hitable> m_object;
+	std::shared_ptr<Material> m_material;
+	int m_materialIndex = -1;
+
+	mat4 m_transform;
+	mat4 m_inverse;
+	// The inverse transpose, for the normals.
+	glm::mat3 m_normalMatrix;
+	Box m_aabb; // In world space.
+};
+
+}
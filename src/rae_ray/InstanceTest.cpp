@@ -0,0 +1,124 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cfloat>
+#include <memory>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Instance.hpp"
+#include "rae_ray/Sphere.hpp"
+
+using namespace rae;
+
+static Ray randomRayTowards(const vec3& target, float distance)
+{
+	vec3 origin = target + distance * glm::normalize(vec3(getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f)));
+	vec3 direction = target + vec3(getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f), getRandom(-1.0f, 1.0f)) - origin;
+	return Ray(origin, direction);
+}
+
+SCENARIO("Instance unittest", "[rae][Instance]")
+{
+	GIVEN( "an instance of a unit sphere moved and scaled, and the same sphere in world space" )
+	{
+		auto unitSphere = std::make_shared<Sphere>(vec3(0.0f, 0.0f, 0.0f), 1.0f, nullptr);
+		const mat4 transform = glm::scale(glm::translate(mat4(1.0f), vec3(3.0f, 1.0f, -2.0f)), vec3(2.0f));
+		Instance instance(unitSphere, transform);
+		Sphere sphere(vec3(3.0f, 1.0f, -2.0f), 2.0f, nullptr);
+
+		THEN( "they have the same box and the same hits" )
+		{
+			REQUIRE(instance.getAabb(0.0f, 0.0f).min().x == Approx(1.0f));
+			REQUIRE(instance.getAabb(0.0f, 0.0f).max().y == Approx(3.0f));
+
+			int mismatches = 0;
+			int hits = 0;
+			for (int i = 0; i < 1000; ++i)
+			{
+				Ray ray = randomRayTowards(vec3(3.0f, 1.0f, -2.0f), 10.0f);
+				HitRecord instanceRecord;
+				HitRecord sphereRecord;
+				bool isInstanceHit = instance.hit(ray, 0.001f, FLT_MAX, instanceRecord);
+				bool isSphereHit = sphere.hit(ray, 0.001f, FLT_MAX, sphereRecord);
+				if (isInstanceHit != isSphereHit || isInstanceHit != instance.occluded(ray, 0.001f, FLT_MAX))
+					mismatches++;
+				else if (isInstanceHit)
+				{
+					hits++;
+					if (std::abs(instanceRecord.t - sphereRecord.t) > 0.0001f
+						|| glm::length(instanceRecord.point - sphereRecord.point) > 0.001f
+						|| glm::length(instanceRecord.normal - sphereRecord.normal) > 0.001f)
+						mismatches++;
+				}
+			}
+			REQUIRE(hits > 100);
+			REQUIRE(mismatches == 0);
+		}
+	}
+
+	GIVEN( "a top level Bvh over a thousand instances of one box mesh" )
+	{
+		auto box = std::make_shared<Mesh>();
+		box->generateBox();
+
+		HitableList world;
+		Array<Instance*> instances;
+		for (int a = 0; a < 40; ++a)
+		{
+			for (int b = 0; b < 25; ++b)
+			{
+				const mat4 transform = glm::rotate(glm::translate(mat4(1.0f), vec3(2.0f * a, 0.0f, 2.0f * b)),
+					getRandom(0.0f, 3.0f), vec3(0.0f, 1.0f, 0.0f));
+				instances.push_back(new Instance(box, transform));
+				world.add(instances.back());
+			}
+		}
+		Bvh tree(world.list());
+
+		THEN( "the mesh is shared and the tree finds the same hits as the list" )
+		{
+			REQUIRE(box.use_count() == 1001);
+
+			int mismatches = 0;
+			int hits = 0;
+			for (int i = 0; i < 2000; ++i)
+			{
+				Ray ray = randomRayTowards(vec3(getRandom(0.0f, 80.0f), 0.0f, getRandom(0.0f, 50.0f)), 20.0f);
+				HitRecord treeRecord;
+				HitRecord listRecord;
+				bool isTreeHit = tree.hit(ray, 0.001f, FLT_MAX, treeRecord);
+				bool isListHit = world.hit(ray, 0.001f, FLT_MAX, listRecord);
+				if (isTreeHit != isListHit || (isTreeHit && treeRecord.t != listRecord.t))
+					mismatches++;
+				if (isTreeHit)
+					hits++;
+			}
+			REQUIRE(hits > 100);
+			REQUIRE(mismatches == 0);
+		}
+
+		THEN( "a moved instance is found in its new place after the top level is rebuilt" )
+		{
+			const Ray ray(vec3(-10.0f, 0.0f, 100.0f), vec3(1.0f, 0.0f, 0.0f));
+			HitRecord record;
+			REQUIRE(tree.hit(ray, 0.001f, FLT_MAX, record) == false);
+
+			instances[0]->setTransform(glm::translate(mat4(1.0f), vec3(0.0f, 0.0f, 100.0f)));
+			tree.build(world.list());
+			REQUIRE(tree.hit(ray, 0.001f, FLT_MAX, record) == true);
+			REQUIRE(record.t == Approx(9.5f));
+			REQUIRE(record.normal.x == Approx(-1.0f));
+		}
+	}
+}
+
+#endif
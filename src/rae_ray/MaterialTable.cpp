@@ -0,0 +1,117 @@
+#include "rae_ray/MaterialTable.hpp"
+
+#include "rae/visual/Material.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/Hitable.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Scattering.hpp"
+
+using namespace rae;
+
+int MaterialTable::addMaterial(MaterialType type, const Color3& color, int parameterIndex)
+{
+	m_types.push_back(type);
+	m_colors.push_back(color);
+	m_parameterIndices.push_back(parameterIndex);
+	return (int)m_types.size() - 1;
+}
+
+int MaterialTable::addLambertian(const Color3& albedo)
+{
+	return addMaterial(MaterialType::Lambertian, albedo, -1);
+}
+
+int MaterialTable::addMetal(const Color3& albedo, float roughness)
+{
+	m_roughnesses.push_back(roughness);
+	return addMaterial(MaterialType::Metal, albedo, (int)m_roughnesses.size() - 1);
+}
+
+int MaterialTable::addDielectric(const Color3& albedo, float refractiveIndex)
+{
+	m_refractiveIndices.push_back(refractiveIndex);
+	return addMaterial(MaterialType::Dielectric, albedo, (int)m_refractiveIndices.size() - 1);
+}
+
+int MaterialTable::addLight(const Color3& emission)
+{
+	return addMaterial(MaterialType::Light, emission, -1);
+}
+
+int MaterialTable::add(const Material& material)
+{
+	auto found = m_indices.find(&material);
+	if (found != m_indices.end())
+		return found->second;
+
+	int index;
+	if (auto metal = dynamic_cast<const Metal*>(&material))
+		index = addMetal(metal->color3(), metal->roughness);
+	else if (auto dielectric = dynamic_cast<const Dielectric*>(&material))
+		index = addDielectric(dielectric->color3(), dielectric->refractiveIndex);
+	else if (dynamic_cast<const Light*>(&material))
+		index = addLight(material.color3());
+	else index = addLambertian(material.color3());
+
+	m_indices.emplace(&material, index);
+	return index;
+}
+
+void MaterialTable::clear()
+{
+	m_types.clear();
+	m_colors.clear();
+	m_parameterIndices.clear();
+	m_roughnesses.clear();
+	m_refractiveIndices.clear();
+	m_indices.clear();
+}
+
+void MaterialTable::bind(const Array<Hitable*>& hitables)
+{
+	clear();
+	for (Hitable* hitable : hitables)
+	{
+		hitable->bindMaterials(*this);
+	}
+}
+
+bool MaterialTable::scatter(int index, const Ray& ray, const HitRecord& record, Sampler& sampler,
+	vec3& attenuation, Ray& scattered) const
+{
+	switch (m_types[index])
+	{
+		case MaterialType::Lambertian:
+			return scatterLambertian(m_colors[index], record, sampler, attenuation, scattered);
+		case MaterialType::Metal:
+			return scatterMetal(m_colors[index], m_roughnesses[m_parameterIndices[index]], ray, record,
+				sampler, attenuation, scattered);
+		case MaterialType::Dielectric:
+			return scatterDielectric(m_refractiveIndices[m_parameterIndices[index]], ray, record,
+				sampler, attenuation, scattered);
+		case MaterialType::Light:
+			return false;
+	}
+	return false;
+}
+
+vec3 MaterialTable::emitted(int index) const
+{
+	if (m_types[index] == MaterialType::Light)
+		return m_colors[index];
+	return vec3(0.0f, 0.0f, 0.0f);
+}
+
+vec3 MaterialTable::evaluate(int index, const HitRecord& record, const vec3& direction) const
+{
+	if (m_types[index] == MaterialType::Lambertian)
+		return evaluateLambertian(m_colors[index], record, direction);
+	return vec3(0.0f, 0.0f, 0.0f);
+}
+
+float MaterialTable::scatterPdf(int index, const HitRecord& record, const vec3& direction) const
+{
+	if (m_types[index] == MaterialType::Lambertian)
+		return lambertianPdf(record, direction);
+	return 0.0f;
+}
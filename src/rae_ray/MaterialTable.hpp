@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+class Hitable;
+class Material;
+class Ray;
+class Sampler;
+struct HitRecord;
+
+enum class MaterialType : uint8_t
+{
+	Lambertian,
+	Metal,
+	Dielectric,
+	Light
+};
+
+// The materials of a tracer scene as plain data, so that shading is a switch on the type instead
+// of virtual calls on Materials all over the heap. Every material has a type and a color, and
+// the parameters of its type are in the array of that type. The hitables keep the index of their
+// material, set by Hitable::bindMaterials, and the hits carry it in HitRecord::materialIndex.
+class MaterialTable
+{
+public:
+	int addLambertian(const Color3& albedo);
+	int addMetal(const Color3& albedo, float roughness);
+	int addDielectric(const Color3& albedo, float refractiveIndex);
+	int addLight(const Color3& emission);
+	// One of the Material classes. The same Material always gets the same index. A plain Material,
+	// like the AssetSystem creates for the entities, is shaded as a Lambertian of its color.
+	int add(const Material& material);
+	void clear();
+	// Clears the table and binds the hitables to it.
+	void bind(const Array<Hitable*>& hitables);
+
+	int size() const { return (int)m_types.size(); }
+	MaterialType type(int index) const { return m_types[index]; }
+	const Color3& color(int index) const { return m_colors[index]; }
+	// Light sampling works with these. The others only scatter to directions of their own choosing.
+	bool isDiffuse(int index) const { return m_types[index] == MaterialType::Lambertian; }
+
+	// The same as the virtual functions of Material.
+	bool scatter(int index, const Ray& ray, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const;
+	vec3 emitted(int index) const;
+	vec3 evaluate(int index, const HitRecord& record, const vec3& direction) const;
+	float scatterPdf(int index, const HitRecord& record, const vec3& direction) const;
+
+protected:
+	int addMaterial(MaterialType type, const Color3& color, int parameterIndex);
+
+	// By material index.
+	Array<MaterialType> m_types;
+	Array<Color3> m_colors;
+	Array<int> m_parameterIndices; // Into the array of the type. -1 for the types without parameters.
+
+	// By parameter index.
+	Array<float> m_roughnesses; // Metal
+	Array<float> m_refractiveIndices; // Dielectric
+
+	std::unordered_map<const Material*, int> m_indices;
+};
+
+}
@@ -0,0 +1,103 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/MaterialTable.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/ReferenceRender.hpp"
+#include "rae_ray/Scenes.hpp"
+
+using namespace rae;
+
+// The colors of the image, shaded from the table, or with the virtual materials without one.
+static Array<vec3> render(PathTracer& pathTracer, const MaterialTable* materials, const Camera& camera,
+	int width, int height, int sampleCount)
+{
+	pathTracer.setMaterials(materials);
+	AccumulationBuffer buffer;
+	buffer.init(width, height);
+	accumulateSamples(pathTracer, camera, buffer, sampleCount);
+	return bufferColors(buffer);
+}
+
+SCENARIO("MaterialTable unittest", "[rae][MaterialTable]")
+{
+	GIVEN( "materials of every type" )
+	{
+		MaterialTable table;
+		Lambertian lambertian(Color3(0.1f, 0.2f, 0.3f));
+		Metal metal(Color3(0.4f, 0.5f, 0.6f), /*roughness*/0.25f);
+		Dielectric dielectric(Color3(0.7f, 0.8f, 0.9f), /*refractiveIndex*/1.5f);
+		Light light(Color3(4.0f, 4.0f, 4.0f));
+		Material plain(Color3(0.3f, 0.3f, 0.3f));
+
+		THEN( "they get their types and colors, and the same material gets the same index" )
+		{
+			const int lambertianIndex = table.add(lambertian);
+			REQUIRE(table.add(metal) == 1);
+			REQUIRE(table.add(dielectric) == 2);
+			REQUIRE(table.add(light) == 3);
+			REQUIRE(table.add(plain) == 4);
+			REQUIRE(table.add(lambertian) == lambertianIndex);
+			REQUIRE(table.size() == 5);
+
+			REQUIRE(table.type(0) == MaterialType::Lambertian);
+			REQUIRE(table.type(1) == MaterialType::Metal);
+			REQUIRE(table.type(2) == MaterialType::Dielectric);
+			REQUIRE(table.type(3) == MaterialType::Light);
+			REQUIRE(table.type(4) == MaterialType::Lambertian); // Like the EntityScene shows them.
+			REQUIRE(table.color(1).g == Approx(0.5f));
+			REQUIRE(table.emitted(3).r == Approx(4.0f));
+			REQUIRE(table.emitted(0).r == 0.0f);
+			REQUIRE(table.isDiffuse(0));
+			REQUIRE(table.isDiffuse(1) == false);
+
+			table.clear();
+			REQUIRE(table.size() == 0);
+		}
+	}
+
+	GIVEN( "scene 1 and the book scene" )
+	{
+		for (int scene : { 1, 3 })
+		{
+			HitableList world;
+			Camera camera;
+			if (scene == 1)
+				createSceneOne(world, camera);
+			else createSceneFromBook(world, camera);
+			camera.calculateFrustum();
+
+			Bvh tree(world.list());
+			MaterialTable table;
+			table.bind(world.list());
+			REQUIRE(table.size() > 0);
+
+			PathTracer pathTracer;
+			pathTracer.setWorld(&tree);
+			pathTracer.findLights(world.list());
+
+			THEN( "shading from the table gives the same colors as the virtual materials" )
+			{
+				const Array<vec3> virtualColors = render(pathTracer, nullptr, camera, 32, 16, 4);
+				const Array<vec3> tableColors = render(pathTracer, &table, camera, 32, 16, 4);
+
+				int mismatches = 0;
+				for (int i = 0; i < (int)virtualColors.size(); ++i)
+				{
+					if (glm::length(virtualColors[i] - tableColors[i]) > 0.0001f)
+						mismatches++;
+				}
+				REQUIRE(mismatches == 0);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include "rae_ray/OfflineRenderer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#include "stb/stb_image_write.h"
+
+#include "rae/core/Utils.hpp"
+#include "rae_ray/Scenes.hpp"
+#include "rae_ray/TileScheduler.hpp"
+
+using namespace rae;
+
+OfflineRenderer::OfflineRenderer(const OfflineRenderSettings& settings) :
+	m_settings(settings),
+	m_world(4)
+{
+}
+
+void OfflineRenderer::createScene()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	m_tree.clear();
+	m_pathTracer.clearLights();
+	m_world.clear();
+	m_materialTable.clear();
+
+	if (m_settings.scene == 3)
+		createSceneFromBook(m_world, m_camera);
+	else if (m_settings.scene == 4)
+		createSceneInstances(m_world, m_camera, /*loadBunny*/true);
+	else createSceneOne(m_world, m_camera, /*loadBunny*/m_settings.scene == 2);
+
+	m_camera.setAspectRatio(float(m_settings.width) / float(m_settings.height));
+	m_camera.calculateFrustum();
+
+	m_stats.sceneTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	m_tree.build(m_world.list());
+
+	// The meshes would build their trees in the first tiles otherwise, one thread at a time,
+	// and the time would go to the render.
+	start = std::chrono::steady_clock::now();
+	for (Hitable* hitable : m_world.list())
+	{
+		hitable->buildTrees();
+	}
+	m_stats.bvhBuildTimeMs = m_tree.stats().buildTimeMs
+		+ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	m_materialTable.bind(m_world.list());
+	m_pathTracer.setWorld(&m_tree);
+	m_pathTracer.setMaterials(&m_materialTable);
+	m_pathTracer.findLights(m_world.list());
+	m_pathTracer.setBouncesLimit(m_settings.bouncesLimit);
+}
+
+void OfflineRenderer::render(ThreadPool& pool)
+{
+	const int width = m_settings.width;
+	const int height = m_settings.height;
+	m_image.init(width, height);
+
+	std::atomic<int64_t> sampleCount(0);
+	std::atomic<int64_t> bounceCount(0);
+	AtomicRayStats rayStats;
+
+	auto start = std::chrono::steady_clock::now();
+
+	TileScheduler tiles;
+	tiles.init(width, height);
+	tiles.run(TileOrder::CenterOut, [&](int tileIndex)
+	{
+		const Tile& tile = tiles.tile(tileIndex);
+		std::unique_ptr<Sampler> sampler = createSampler(m_settings.samplerType, m_settings.seed);
+		int64_t tileSampleCount = 0;
+		int64_t tileBounceCount = 0;
+		RayStats tileStart;
+		if (RayStats::IsEnabled)
+			tileStart = threadRayStats();
+		for (int y = tile.y; y < tile.y + tile.height; ++y)
+		{
+			for (int x = tile.x; x < tile.x + tile.width; ++x)
+			{
+				for (int sample = 0; sample < m_settings.samplesPerPixel; ++sample)
+				{
+					FirstHit firstHit;
+					int bounces = 0;
+					vec3 color = m_pathTracer.renderPixelSample(m_camera, *sampler, x, y, width, height, sample,
+						&firstHit, &bounces);
+					m_image.addSample(x, y, color, firstHit);
+					tileBounceCount += bounces;
+				}
+				tileSampleCount += m_settings.samplesPerPixel;
+			}
+		}
+		sampleCount += tileSampleCount;
+		bounceCount += tileBounceCount;
+		if (RayStats::IsEnabled)
+		{
+			RayStats tileStats = threadRayStats() - tileStart;
+			tileStats.bounceCount = tileBounceCount;
+			tileStats.sampleCount = tileSampleCount;
+			rayStats.add(tileStats);
+		}
+	}, pool);
+
+	m_stats.renderTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_stats.sampleCount = sampleCount;
+	m_stats.primaryRayCount = sampleCount;
+	m_stats.secondaryRayCount = bounceCount;
+	m_stats.threadCount = pool.concurrency();
+	m_stats.rayStats = rayStats.load();
+}
+
+bool OfflineRenderer::writePng(const String& filename) const
+{
+	const int width = m_image.width();
+	const int height = m_image.height();
+	Array<uint8_t> data(width * height * 3);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const vec3 color = glm::clamp(glm::pow(m_image.color(x, y), vec3(1.0f / 2.2f)), 0.0f, 1.0f);
+			uint8_t* pixel = &data[(y * width + x) * 3];
+			pixel[0] = uint8_t(255.99f * color.r);
+			pixel[1] = uint8_t(255.99f * color.g);
+			pixel[2] = uint8_t(255.99f * color.b);
+		}
+	}
+	return stbi_write_png(filename.c_str(), width, height, 3, &data[0], width * 3) != 0;
+}
+
+bool OfflineRenderer::writePfm(const String& filename) const
+{
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	// A negative scale means little endian. The rows go from the bottom up.
+	const int width = m_image.width();
+	const int height = m_image.height();
+	fprintf(file, "PF\n%i %i\n-1.0\n", width, height);
+	Array<float> row(width * 3);
+	bool isWritten = true;
+	for (int y = height - 1; y >= 0; --y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const vec3 color = m_image.color(x, y);
+			row[x * 3 + 0] = color.r;
+			row[x * 3 + 1] = color.g;
+			row[x * 3 + 2] = color.b;
+		}
+		if (fwrite(&row[0], sizeof(float), row.size(), file) != row.size())
+			isWritten = false;
+	}
+	return fclose(file) == 0 && isWritten;
+}
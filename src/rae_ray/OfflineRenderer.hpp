@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "rae/core/Types.hpp"
+#include "rae/core/ThreadPool.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/MaterialTable.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/RayStats.hpp"
+#include "rae_ray/Sampler.hpp"
+
+namespace rae
+{
+
+struct OfflineRenderSettings
+{
+	// 1 and 2 are scene one without and with the bunny, 3 is the scene from the book, 4 has 1024 bunny instances.
+	int scene = 1;
+	int width = 640;
+	int height = 360;
+	int samplesPerPixel = 16;
+	int bouncesLimit = 50;
+	uint64_t seed = 0;
+	SamplerType samplerType = SamplerType::Sobol;
+};
+
+struct OfflineRenderStats
+{
+	double sceneTimeMs = 0.0; // Creating the scene, including loading the meshes.
+	double bvhBuildTimeMs = 0.0; // The tree over the hitables, and the triangle trees of the meshes.
+	double renderTimeMs = 0.0;
+	int64_t sampleCount = 0;
+	// The camera rays and the bounces after them. Shadow rays to the lights are not counted.
+	int64_t primaryRayCount = 0;
+	int64_t secondaryRayCount = 0;
+	int threadCount = 0;
+	RayStats rayStats; // All zeros without RAE_RAY_STATS.
+
+	int64_t rayCount() const { return primaryRayCount + secondaryRayCount; }
+};
+
+// Renders a whole image at once without a window or the engine, for batch renders, regression
+// tests and benchmarks. The same settings give the same image on any number of threads.
+class OfflineRenderer
+{
+public:
+	OfflineRenderer(const OfflineRenderSettings& settings);
+
+	static bool isValidScene(int scene) { return scene >= 1 && scene <= 4; }
+
+	// Creates the scene and builds the tree.
+	void createScene();
+	// Renders all the samples of all the pixels, from scratch.
+	void render(ThreadPool& pool = getThreadPool());
+
+	const OfflineRenderSettings& settings() const { return m_settings; }
+	const OfflineRenderStats& stats() const { return m_stats; }
+	const BvhStats& bvhStats() const { return m_tree.stats(); }
+	const AccumulationBuffer& image() const { return m_image; }
+
+	// Gamma corrected 8-bit color.
+	bool writePng(const String& filename) const;
+	// Linear float color in the Portable FloatMap format, without any loss.
+	bool writePfm(const String& filename) const;
+
+protected:
+	OfflineRenderSettings m_settings;
+	OfflineRenderStats m_stats;
+
+	HitableList m_world;
+	MaterialTable m_materialTable;
+	Bvh m_tree;
+	Camera m_camera;
+	PathTracer m_pathTracer;
+	AccumulationBuffer m_image;
+};
+
+}
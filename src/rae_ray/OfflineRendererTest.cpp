@@ -0,0 +1,50 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include "rae/core/ThreadPool.hpp"
+#include "rae_ray/OfflineRenderer.hpp"
+
+using namespace rae;
+
+SCENARIO("OfflineRenderer unittest", "[rae][OfflineRenderer]")
+{
+	GIVEN( "a small render of scene one" )
+	{
+		OfflineRenderSettings settings;
+		settings.width = 48;
+		settings.height = 27;
+		settings.samplesPerPixel = 2;
+		settings.seed = 7;
+
+		OfflineRenderer renderer(settings);
+		renderer.createScene();
+
+		THEN( "one thread and many threads render the same image" )
+		{
+			ThreadPool onePool(0);
+			renderer.render(onePool);
+			const AccumulationBuffer single = renderer.image();
+			REQUIRE(renderer.stats().threadCount == 1);
+			REQUIRE(renderer.stats().sampleCount == 48 * 27 * 2);
+			REQUIRE(renderer.stats().secondaryRayCount > 0);
+
+			ThreadPool manyPool(3);
+			renderer.render(manyPool);
+
+			bool isSame = true;
+			for (int y = 0; y < settings.height; ++y)
+			{
+				for (int x = 0; x < settings.width; ++x)
+				{
+					if (renderer.image().color(x, y) != single.color(x, y))
+						isSame = false;
+				}
+			}
+			REQUIRE(isSame == true);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,269 @@
+#include "rae_ray/PathTracer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rae/core/Utils.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/Hitable.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/MaterialTable.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/Sphere.hpp"
+
+using namespace rae;
+
+vec3 PathTracer::renderPixelSample(const Camera& camera, Sampler& sampler, int x, int y, int width, int height, int sampleIndex,
+	FirstHit* firstHit, int* bounceCount) const
+{
+	sampler.startPixelSample(x, y, sampleIndex);
+
+	vec2 jitter = sampler.get2D();
+	float u = float(x + jitter.x) / float(width);
+	float v = float(y + jitter.y) / float(height);
+
+	Ray ray = camera.getRay(u, v, sampler.get2D());
+	return rayTrace(ray, sampler, bounceCount, firstHit);
+}
+
+const int PathTracer::RouletteStartBounce;
+
+void PathTracer::findLights(const Array<Hitable*>& hitables)
+{
+	m_lights.clear();
+	for (const Hitable* hitable : hitables)
+	{
+		const Sphere* sphere = dynamic_cast<const Sphere*>(hitable);
+		if (sphere && dynamic_cast<const Light*>(sphere->material))
+		{
+			m_lights.push_back({ sphere->center, sphere->radius, sphere->material, sphere->materialIndex });
+		}
+	}
+}
+
+const SphereLight* PathTracer::findLight(const Material* material) const
+{
+	for (const SphereLight& light : m_lights)
+	{
+		if (light.material == material)
+			return &light;
+	}
+	return nullptr;
+}
+
+bool PathTracer::isInTable(const HitRecord& record) const
+{
+	return m_materials && record.materialIndex >= 0;
+}
+
+Color3 PathTracer::materialColor(const HitRecord& record) const
+{
+	return isInTable(record) ? m_materials->color(record.materialIndex) : record.material->color3();
+}
+
+vec3 PathTracer::emitted(const HitRecord& record) const
+{
+	return isInTable(record) ? m_materials->emitted(record.materialIndex) : record.material->emitted(record.point);
+}
+
+vec3 PathTracer::emitted(const SphereLight& light, const vec3& point) const
+{
+	return m_materials && light.materialIndex >= 0 ? m_materials->emitted(light.materialIndex) : light.material->emitted(point);
+}
+
+bool PathTracer::isDiffuse(const HitRecord& record) const
+{
+	return isInTable(record) ? m_materials->isDiffuse(record.materialIndex) : record.material->isDiffuse();
+}
+
+bool PathTracer::scatter(const Ray& ray, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const
+{
+	if (isInTable(record))
+		return m_materials->scatter(record.materialIndex, ray, record, sampler, attenuation, scattered);
+	return record.material->scatter(ray, record, sampler, attenuation, scattered);
+}
+
+vec3 PathTracer::evaluate(const HitRecord& record, const vec3& direction) const
+{
+	return isInTable(record) ? m_materials->evaluate(record.materialIndex, record, direction) : record.material->evaluate(record, direction);
+}
+
+float PathTracer::scatterPdf(const HitRecord& record, const vec3& direction) const
+{
+	return isInTable(record) ? m_materials->scatterPdf(record.materialIndex, record, direction) : record.material->scatterPdf(record, direction);
+}
+
+// Veach's power heuristic with beta 2.
+static float powerHeuristic(float pdf, float otherPdf)
+{
+	return (pdf * pdf) / (pdf * pdf + otherPdf * otherPdf);
+}
+
+// 1 - cos of the half angle of the cone that the sphere covers, seen from a point outside it.
+// Computed from the sine, as 1 - cos loses the precision for small and far lights.
+static float coneOneMinusCos(float distanceSquared, float radius)
+{
+	const float sinSquared = radius * radius / distanceSquared;
+	const float cosMax = std::sqrt(std::max(0.0f, 1.0f - sinSquared));
+	return sinSquared / (1.0f + cosMax);
+}
+
+float PathTracer::lightPdf(const vec3& point, const SphereLight& light) const
+{
+	const vec3 toLight = light.center - point;
+	const float distanceSquared = glm::dot(toLight, toLight);
+	if (distanceSquared <= light.radius * light.radius)
+		return 0.0f; // Inside the light, sampleLight skips it.
+
+	const float solidAngle = Math::TAU * coneOneMinusCos(distanceSquared, light.radius);
+	return 1.0f / (solidAngle * float(m_lights.size()));
+}
+
+vec3 PathTracer::sampleLight(const HitRecord& record, Sampler& sampler) const
+{
+	const int lightIndex = std::min(int(sampler.get1D() * m_lights.size()), int(m_lights.size()) - 1);
+	const SphereLight& light = m_lights[lightIndex];
+	const vec2 u = sampler.get2D();
+
+	const vec3 toLight = light.center - record.point;
+	const float distanceSquared = glm::dot(toLight, toLight);
+	if (distanceSquared <= light.radius * light.radius)
+		return vec3(0.0f, 0.0f, 0.0f);
+
+	// A uniform direction in the cone towards the light.
+	const float distance = std::sqrt(distanceSquared);
+	const vec3 w = toLight / distance;
+	const vec3 helper = std::abs(w.x) > 0.9f ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+	const vec3 tangent = glm::normalize(glm::cross(helper, w));
+	const vec3 bitangent = glm::cross(w, tangent);
+
+	const float oneMinusCos = u.x * coneOneMinusCos(distanceSquared, light.radius);
+	const float cosTheta = 1.0f - oneMinusCos;
+	const float sinTheta = std::sqrt(std::max(0.0f, oneMinusCos * (2.0f - oneMinusCos)));
+	const float phi = Math::TAU * u.y;
+	const vec3 direction = glm::normalize(
+		tangent * (std::cos(phi) * sinTheta) + bitangent * (std::sin(phi) * sinTheta) + w * cosTheta);
+
+	const vec3 bsdf = evaluate(record, direction);
+	if (bsdf == vec3(0.0f, 0.0f, 0.0f))
+		return vec3(0.0f, 0.0f, 0.0f);
+
+	// Distance to the near side of the light. The light itself must not count as a blocker.
+	const float b = glm::dot(toLight, direction);
+	const float lightDistance = b - std::sqrt(std::max(0.0f, b * b - distanceSquared + light.radius * light.radius));
+	if (m_world->occluded(Ray(record.point, direction), 0.001f, lightDistance * 0.999f))
+		return vec3(0.0f, 0.0f, 0.0f);
+
+	const float pdf = lightPdf(record.point, light);
+	const float weight = powerHeuristic(pdf, scatterPdf(record, direction));
+	return bsdf * emitted(light, record.point + direction * lightDistance) * (weight / pdf);
+}
+
+vec3 PathTracer::rayTrace(const Ray& cameraRay, Sampler& sampler, int* bounceCount, FirstHit* firstHit) const
+{
+	vec3 color(0.0f, 0.0f, 0.0f);
+	vec3 throughput(1.0f, 1.0f, 1.0f); // How much of the light from further on reaches the camera.
+	Ray ray = cameraRay;
+	int bounce = 0;
+
+	const bool isLightSampling = m_isLightSampling && m_lights.empty() == false;
+	// Set when the ray was scattered from a diffuse hit, where the lights were also sampled.
+	bool isFromDiffuse = false;
+	float diffuseScatterPdf = 0.0f;
+
+	for (;; ++bounce)
+	{
+		HitRecord record;
+		if (m_world->hit(ray, 0.001f, m_maxRayLength, record) == false)
+		{
+			if (bounce == 0 && firstHit)
+			{
+				*firstHit = FirstHit();
+				firstHit->albedo = sky(ray);
+			}
+			color += throughput * sky(ray);
+			break;
+		}
+
+		if (bounce == 0 && firstHit)
+		{
+			firstHit->albedo = materialColor(record);
+			firstHit->normal = record.normal;
+			firstHit->position = record.point;
+			firstHit->depth = record.t * glm::length(ray.direction());
+		}
+
+		// Visualize focus distance with a line
+		if (m_focusCamera)
+		{
+			float hitDistance = glm::length(record.point - m_focusCamera->position());
+			if (Utils::isEqual(m_focusCamera->focusDistance(), hitDistance, 0.01f) == true)
+			{
+				color += throughput * vec3(0,1,1); // cyan line
+				break;
+			}
+		}
+
+		// FastMode returns just the material color
+		if (m_isFastMode)
+		{
+			color += throughput * materialColor(record);
+			break;
+		}
+
+		vec3 emittedColor = emitted(record);
+		if (isLightSampling && isFromDiffuse)
+		{
+			// The light sampling at the previous hit could have found this light too.
+			const SphereLight* light = findLight(record.material);
+			if (light)
+				emittedColor *= powerHeuristic(diffuseScatterPdf, lightPdf(ray.origin(), *light));
+		}
+		color += throughput * emittedColor;
+
+		// The bounce limit is a hard cap, also with Russian roulette.
+		if (bounce >= m_bouncesLimit)
+			break;
+
+		isFromDiffuse = isLightSampling && isDiffuse(record);
+		if (isFromDiffuse)
+		{
+			color += throughput * sampleLight(record, sampler);
+		}
+
+		Ray scattered;
+		vec3 attenuation;
+		if (scatter(ray, record, sampler, attenuation, scattered) == false)
+			break;
+
+		if (isFromDiffuse)
+			diffuseScatterPdf = scatterPdf(record, glm::normalize(scattered.direction()));
+
+		throughput *= attenuation;
+		ray = scattered;
+
+		// Russian roulette: end dim paths randomly, and make up for it by weighting the survivors,
+		// so that the result stays unbiased.
+		if (m_isRussianRoulette && bounce + 1 >= RouletteStartBounce)
+		{
+			float survival = std::min(0.95f, std::max(throughput.r, std::max(throughput.g, throughput.b)));
+			if (survival <= 0.0f || sampler.get1D() >= survival)
+				break;
+			throughput /= survival;
+		}
+	}
+
+	if (bounceCount)
+		*bounceCount = bounce;
+	return color;
+}
+
+vec3 PathTracer::sky(const Ray& ray) const
+{
+	vec3 unitDirection = glm::normalize(ray.direction());
+	float t = 0.5f * (unitDirection.y + 1.0f);
+	//return (1.0f - t) * vec3(0.3f, 0.4f, 1.0f) + t * vec3(0.7f, 0.8f, 1.0f);
+	return (1.0f - t) * vec3(0.0f, 0.0f, 0.0f) + t * vec3(0.05f, 0.05f, 0.05f);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cfloat>
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+class Ray;
+class Camera;
+class Hitable;
+class Material;
+class MaterialTable;
+class Sampler;
+struct HitRecord;
+
+// What the camera ray hit first. The denoiser uses these to find the edges in the image,
+// and the reprojection to check that a pixel still shows the same surface.
+struct FirstHit
+{
+	vec3 albedo = vec3(0.0f, 0.0f, 0.0f); // The material color, or the sky for a miss.
+	vec3 normal = vec3(0.0f, 0.0f, 0.0f); // Zero for a miss.
+	vec3 position = vec3(0.0f, 0.0f, 0.0f); // In world space, zero for a miss.
+	float depth = 0.0f; // Distance from the ray origin, zero for a miss.
+};
+
+// A sphere with an emitting material, sampled directly for next event estimation.
+struct SphereLight
+{
+	vec3 center;
+	float radius;
+	const Material* material;
+	int materialIndex; // Into the MaterialTable, or -1.
+};
+
+// Traces the paths of camera samples through a world. Knows nothing about windows, buffers
+// or time, so that the interactive RayTracer, tests and benchmarks all render the same way.
+class PathTracer
+{
+public:
+	// Russian roulette starts after this many bounces.
+	static const int RouletteStartBounce = 3;
+
+	void setWorld(const Hitable* world) { m_world = world; }
+	const Hitable* world() const { return m_world; }
+
+	// The table that the material indices of the hits refer to, bound to the hitables of the
+	// world. The hits without an index, or all of them without a table, are shaded with the
+	// virtual functions of their Material.
+	void setMaterials(const MaterialTable* materials) { m_materials = materials; }
+	const MaterialTable* materials() const { return m_materials; }
+
+	void setBouncesLimit(int limit) { m_bouncesLimit = limit; }
+	int bouncesLimit() const { return m_bouncesLimit; }
+
+	// Finds the spheres with a Light material among the hitables, for light sampling.
+	void findLights(const Array<Hitable*>& hitables);
+	void clearLights() { m_lights.clear(); }
+	const Array<SphereLight>& lights() const { return m_lights; }
+
+	// Next event estimation: at diffuse hits, sample a point on a light and cast a shadow ray
+	// to it, combined with the bounces that hit lights by multiple importance sampling.
+	// On by default.
+	void setLightSampling(bool set) { m_isLightSampling = set; }
+	bool isLightSampling() const { return m_isLightSampling; }
+
+	// Ends dim paths early at random, without biasing the result. On by default.
+	void setRussianRoulette(bool set) { m_isRussianRoulette = set; }
+	bool isRussianRoulette() const { return m_isRussianRoulette; }
+
+	void setMaxRayLength(float length) { m_maxRayLength = length; }
+	// Fast mode returns just the material color of the first hit.
+	void setFastMode(bool set) { m_isFastMode = set; }
+	// When set, hits at the focus distance of the camera are drawn as a cyan line.
+	void setFocusCamera(const Camera* camera) { m_focusCamera = camera; }
+
+	// Color of one sample of pixel (x, y) in an image of width x height pixels.
+	vec3 renderPixelSample(const Camera& camera, Sampler& sampler, int x, int y, int width, int height, int sampleIndex,
+		FirstHit* firstHit = nullptr, int* bounceCount = nullptr) const;
+
+	// Follows the path of the ray until it escapes, is absorbed, loses the Russian roulette
+	// or hits the bounces limit. Sets bounceCount to the number of bounces and firstHit to
+	// what the ray hit first if given.
+	vec3 rayTrace(const Ray& ray, Sampler& sampler, int* bounceCount = nullptr, FirstHit* firstHit = nullptr) const;
+	vec3 sky(const Ray& ray) const;
+
+protected:
+	// Light from a randomly picked light to the hit point, weighted for multiple importance sampling.
+	vec3 sampleLight(const HitRecord& record, Sampler& sampler) const;
+	// Probability density of sampleLight choosing the direction from point towards the light.
+	float lightPdf(const vec3& point, const SphereLight& light) const;
+	const SphereLight* findLight(const Material* material) const;
+
+	// The shading step: a switch in the MaterialTable when the hit has a material index,
+	// otherwise a virtual call on the Material.
+	bool isInTable(const HitRecord& record) const;
+	Color3 materialColor(const HitRecord& record) const;
+	vec3 emitted(const HitRecord& record) const;
+	vec3 emitted(const SphereLight& light, const vec3& point) const;
+	bool isDiffuse(const HitRecord& record) const;
+	bool scatter(const Ray& ray, const HitRecord& record, Sampler& sampler, vec3& attenuation, Ray& scattered) const;
+	vec3 evaluate(const HitRecord& record, const vec3& direction) const;
+	float scatterPdf(const HitRecord& record, const vec3& direction) const;
+
+	Array<SphereLight> m_lights;
+	bool m_isLightSampling = true;
+
+	const Hitable* m_world = nullptr;
+	const MaterialTable* m_materials = nullptr;
+	int m_bouncesLimit = 50;
+	bool m_isRussianRoulette = true;
+	float m_maxRayLength = FLT_MAX;
+	bool m_isFastMode = false;
+	const Camera* m_focusCamera = nullptr;
+};
+
+}
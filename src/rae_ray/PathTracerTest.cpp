@@ -0,0 +1,127 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cmath>
+
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/ReferenceRender.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/Scenes.hpp"
+#include "rae_ray/Sphere.hpp"
+
+using namespace rae;
+
+SCENARIO("PathTracer unittest", "[rae][PathTracer]")
+{
+	GIVEN( "two perfect mirrors facing each other" )
+	{
+		HitableList world;
+		world.create<Sphere>(vec3(-2.0f, 0.0f, 0.0f), 1.0f, world.createMaterial<Metal>(vec3(1.0f, 1.0f, 1.0f), /*roughness*/0.0f));
+		world.create<Sphere>(vec3(2.0f, 0.0f, 0.0f), 1.0f, world.createMaterial<Metal>(vec3(1.0f, 1.0f, 1.0f), /*roughness*/0.0f));
+
+		PathTracer pathTracer;
+		pathTracer.setWorld(&world);
+		SobolSampler sampler;
+		sampler.startPixelSample(0, 0, 0);
+		const Ray ray(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f));
+
+		WHEN( "the bounces limit is very high and there is no Russian roulette" )
+		{
+			pathTracer.setRussianRoulette(false);
+			pathTracer.setBouncesLimit(100000);
+
+			THEN( "the path stops at the limit without running out of stack" )
+			{
+				int bounces = 0;
+				pathTracer.rayTrace(ray, sampler, &bounces);
+				REQUIRE(bounces == 100000);
+			}
+		}
+
+		WHEN( "Russian roulette is on" )
+		{
+			pathTracer.setBouncesLimit(100000);
+
+			THEN( "the path ends long before the limit" )
+			{
+				int totalBounces = 0;
+				for (int sample = 0; sample < 100; ++sample)
+				{
+					sampler.startPixelSample(0, 0, sample);
+					int bounces = 0;
+					pathTracer.rayTrace(ray, sampler, &bounces);
+					totalBounces += bounces;
+				}
+				REQUIRE(totalBounces < 100 * 1000);
+			}
+		}
+	}
+}
+
+// Mean and variance of the color of many samples of one ray.
+static void traceSamples(const PathTracer& pathTracer, const Ray& ray, int sampleCount, vec3& outMean, float& outVariance)
+{
+	SobolSampler sampler(/*seed*/5);
+	vec3 sum;
+	double sumOfSquares = 0.0;
+	for (int sample = 0; sample < sampleCount; ++sample)
+	{
+		sampler.startPixelSample(0, 0, sample);
+		vec3 color = pathTracer.rayTrace(ray, sampler);
+		sum += color;
+		sumOfSquares += glm::dot(color, color);
+	}
+	outMean = sum / float(sampleCount);
+	outVariance = float(sumOfSquares / sampleCount) - glm::dot(outMean, outMean);
+}
+
+SCENARIO("PathTracer light sampling unittest", "[rae][PathTracer]")
+{
+	GIVEN( "a diffuse floor under a spherical light" )
+	{
+		HitableList world;
+		world.create<Sphere>(vec3(0.0f, -1000.0f, 0.0f), 1000.0f, world.createMaterial<Lambertian>(vec3(0.5f, 0.5f, 0.5f)));
+		world.create<Sphere>(vec3(0.0f, 3.0f, 0.0f), 1.0f, world.createMaterial<Light>(vec3(4.0f, 4.0f, 4.0f)));
+
+		PathTracer pathTracer;
+		pathTracer.setWorld(&world);
+		pathTracer.findLights(world.list());
+		REQUIRE(pathTracer.lights().size() == 1);
+
+		const Ray ray(vec3(0.0f, 1.0f, 5.0f), vec3(0.0f, -1.0f, -5.0f));
+
+		THEN( "sampling the light gives the same result with less noise" )
+		{
+			vec3 bounceMean;
+			float bounceVariance;
+			pathTracer.setLightSampling(false);
+			traceSamples(pathTracer, ray, 20000, bounceMean, bounceVariance);
+
+			vec3 lightMean;
+			float lightVariance;
+			pathTracer.setLightSampling(true);
+			traceSamples(pathTracer, ray, 20000, lightMean, lightVariance);
+
+			REQUIRE(bounceMean.r > 0.01f);
+			REQUIRE(std::abs(lightMean.r - bounceMean.r) < 0.03f * bounceMean.r);
+			REQUIRE(lightVariance < 0.5f * bounceVariance);
+		}
+
+		THEN( "shadow rays don't pass through other objects" )
+		{
+			world.add(new Sphere(vec3(0.0f, 1.0f, 0.0f), 0.5f, nullptr));
+			REQUIRE(world.occluded(Ray(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f)), 0.001f, 1.9f) == true);
+			REQUIRE(world.occluded(Ray(vec3(3.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f)), 0.001f, 1.9f) == false);
+		}
+	}
+}
+
+#endif
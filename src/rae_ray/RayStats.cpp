@@ -0,0 +1,71 @@
+#include "rae_ray/RayStats.hpp"
+
+#include <initializer_list>
+
+using namespace rae;
+
+constexpr bool RayStats::IsEnabled;
+
+RayStats& RayStats::operator+=(const RayStats& other)
+{
+	bvhNodeCount += other.bvhNodeCount;
+	aabbTestCount += other.aabbTestCount;
+	sphereTestCount += other.sphereTestCount;
+	triangleTestCount += other.triangleTestCount;
+	bounceCount += other.bounceCount;
+	sampleCount += other.sampleCount;
+	return *this;
+}
+
+RayStats RayStats::operator-(const RayStats& other) const
+{
+	RayStats result;
+	result.bvhNodeCount = bvhNodeCount - other.bvhNodeCount;
+	result.aabbTestCount = aabbTestCount - other.aabbTestCount;
+	result.sphereTestCount = sphereTestCount - other.sphereTestCount;
+	result.triangleTestCount = triangleTestCount - other.triangleTestCount;
+	result.bounceCount = bounceCount - other.bounceCount;
+	result.sampleCount = sampleCount - other.sampleCount;
+	return result;
+}
+
+void PixelRayStats::add(const RayStats& stats)
+{
+	bvhNodeCount += uint32_t(stats.bvhNodeCount);
+	aabbTestCount += uint32_t(stats.aabbTestCount);
+	primitiveTestCount += uint32_t(stats.primitiveTestCount());
+	bounceCount += uint32_t(stats.bounceCount);
+	sampleCount += uint32_t(stats.sampleCount);
+}
+
+// Only totals are read, so the adds don't need to be ordered with anything else.
+void AtomicRayStats::add(const RayStats& stats)
+{
+	m_bvhNodeCount.fetch_add(stats.bvhNodeCount, std::memory_order_relaxed);
+	m_aabbTestCount.fetch_add(stats.aabbTestCount, std::memory_order_relaxed);
+	m_sphereTestCount.fetch_add(stats.sphereTestCount, std::memory_order_relaxed);
+	m_triangleTestCount.fetch_add(stats.triangleTestCount, std::memory_order_relaxed);
+	m_bounceCount.fetch_add(stats.bounceCount, std::memory_order_relaxed);
+	m_sampleCount.fetch_add(stats.sampleCount, std::memory_order_relaxed);
+}
+
+RayStats AtomicRayStats::load() const
+{
+	RayStats stats;
+	stats.bvhNodeCount = m_bvhNodeCount.load(std::memory_order_relaxed);
+	stats.aabbTestCount = m_aabbTestCount.load(std::memory_order_relaxed);
+	stats.sphereTestCount = m_sphereTestCount.load(std::memory_order_relaxed);
+	stats.triangleTestCount = m_triangleTestCount.load(std::memory_order_relaxed);
+	stats.bounceCount = m_bounceCount.load(std::memory_order_relaxed);
+	stats.sampleCount = m_sampleCount.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void AtomicRayStats::clear()
+{
+	for (std::atomic<int64_t>* count : { &m_bvhNodeCount, &m_aabbTestCount, &m_sphereTestCount,
+		&m_triangleTestCount, &m_bounceCount, &m_sampleCount })
+	{
+		count->store(0, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+namespace rae
+{
+
+// Counts of the work done to trace rays, for tuning the trees and the scenes. The tracing code
+// only counts when RAE_RAY_STATS is defined (premake4 --stats), otherwise the counting is
+// compiled out and the counts stay at zero.
+struct RayStats
+{
+#ifdef RAE_RAY_STATS
+	static constexpr bool IsEnabled = true;
+#else
+	static constexpr bool IsEnabled = false;
+#endif
+
+	int64_t bvhNodeCount = 0; // Nodes entered, in all the trees.
+	int64_t aabbTestCount = 0; // Ray and box tests, also the ones that missed.
+	int64_t sphereTestCount = 0;
+	int64_t triangleTestCount = 0;
+	// Counted by the renderers from the samples they take, not by the tracing code.
+	int64_t bounceCount = 0;
+	int64_t sampleCount = 0;
+
+	int64_t primitiveTestCount() const { return sphereTestCount + triangleTestCount; }
+	// Per sample.
+	double average(int64_t count) const { return sampleCount > 0 ? double(count) / double(sampleCount) : 0.0; }
+
+	RayStats& operator+=(const RayStats& other);
+	RayStats operator-(const RayStats& other) const;
+};
+
+// The counts of one pixel, summed over its samples. Smaller than RayStats, for a whole image of them.
+struct PixelRayStats
+{
+	uint32_t bvhNodeCount = 0;
+	uint32_t aabbTestCount = 0;
+	uint32_t primitiveTestCount = 0;
+	uint32_t bounceCount = 0;
+	uint32_t sampleCount = 0;
+
+	void add(const RayStats& stats);
+};
+
+// Each thread counts to its own, so the tracing code never touches memory shared with other
+// threads. The renderers take the difference over a tile and add it to an AtomicRayStats.
+inline RayStats& threadRayStats()
+{
+	static thread_local RayStats stats;
+	return stats;
+}
+
+#ifdef RAE_RAY_STATS
+	#define RAE_COUNT_RAY_STAT(counter, count) (rae::threadRayStats().counter += (count))
+#else
+	#define RAE_COUNT_RAY_STAT(counter, count) ((void)0)
+#endif
+
+// Totals from many threads, added without a lock.
+class AtomicRayStats
+{
+public:
+	void add(const RayStats& stats);
+	RayStats load() const;
+	void clear();
+
+protected:
+	std::atomic<int64_t> m_bvhNodeCount{0};
+	std::atomic<int64_t> m_aabbTestCount{0};
+	std::atomic<int64_t> m_sphereTestCount{0};
+	std::atomic<int64_t> m_triangleTestCount{0};
+	std::atomic<int64_t> m_bounceCount{0};
+	std::atomic<int64_t> m_sampleCount{0};
+};
+
+}
@@ -0,0 +1,73 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cfloat>
+
+#include "rae/core/Utils.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/RayStats.hpp"
+#include "rae_ray/SphereSet.hpp"
+
+using namespace rae;
+
+SCENARIO("RayStats unittest", "[rae][RayStats]")
+{
+	GIVEN( "stats added from many threads at once" )
+	{
+		AtomicRayStats totals;
+		parallel_for(0, 1000, [&](int /*i*/)
+		{
+			RayStats stats;
+			stats.bvhNodeCount = 2;
+			stats.triangleTestCount = 3;
+			stats.sampleCount = 1;
+			totals.add(stats);
+		}, /*grainSize*/1);
+
+		THEN( "none of them are lost" )
+		{
+			const RayStats stats = totals.load();
+			REQUIRE(stats.bvhNodeCount == 2000);
+			REQUIRE(stats.primitiveTestCount() == 3000);
+			REQUIRE(stats.average(stats.triangleTestCount) == Approx(3.0));
+		}
+	}
+
+	GIVEN( "a ray through a set of spheres" )
+	{
+		SphereSet spheres;
+		for (int i = 0; i < 64; ++i)
+		{
+			spheres.add(vec3(float(i % 8), 0.0f, float(i / 8)), 0.25f, nullptr);
+		}
+		spheres.build();
+
+		const RayStats start = threadRayStats();
+		HitRecord record;
+		const bool isHit = spheres.hit(Ray(vec3(0.0f, 5.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f)), 0.001f, FLT_MAX, record);
+		const RayStats stats = threadRayStats() - start;
+
+		THEN( "the work is counted only with RAE_RAY_STATS" )
+		{
+			REQUIRE(isHit == true);
+			if (RayStats::IsEnabled)
+			{
+				REQUIRE(stats.bvhNodeCount > 0);
+				REQUIRE(stats.aabbTestCount >= stats.bvhNodeCount);
+				// The tree skips most of the spheres.
+				REQUIRE(stats.sphereTestCount > 0);
+				REQUIRE(stats.sphereTestCount < 64);
+			}
+			else
+			{
+				REQUIRE(stats.aabbTestCount == 0);
+				REQUIRE(stats.sphereTestCount == 0);
+			}
+		}
+	}
+}
+
+#endif
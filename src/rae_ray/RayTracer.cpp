@@ -1,5 +1,6 @@
 #include "RayTracer.hpp"
 
+#include <algorithm>
 #include <thread>
 
 #include "rae/core/Utils.hpp"
@@ -10,189 +11,214 @@
 
 #include "rae/visual/CameraSystem.hpp"
 #include "rae/visual/Material.hpp"
+#include "rae_ray/Sampler.hpp"
 #include "rae_ray/Sphere.hpp"
+#include "rae_ray/Scenes.hpp"
 #include "rae/visual/Mesh.hpp"
 #include "rae/image/ImageBuffer.hpp"
 
 using namespace rae;
 
+const int RayTracer::MinAdaptiveSamples;
+const int RayTracer::MaxAdaptiveSamplesPerPass;
+const int RayTracer::MaxRenderDivider;
+
+String rae::toString(DisplayMode mode)
+{
+	switch (mode)
+	{
+		case DisplayMode::Color: return "colors";
+		case DisplayMode::SampleCount: return "samples per pixel";
+		case DisplayMode::BvhNodes: return "BVH nodes per sample";
+		case DisplayMode::AabbTests: return "AABB tests per sample";
+		case DisplayMode::PrimitiveTests: return "primitive tests per sample";
+		case DisplayMode::PathLength: return "path length";
+		default: return "Unknown";
+	}
+}
+
 RayTracer::RayTracer(const Time& time, CameraSystem& cameraSystem) :
-	m_world(4),
+	m_isSceneChanging(false),
+	m_isClearPending(false),
+	m_isResolvePending(false),
+	m_isHistoryDiscarded(true),
+	m_renderWidth(0),
+	m_renderHeight(0),
+	m_displayMode(DisplayMode::Color),
+	m_isDenoising(false),
 	m_time(time),
 	m_cameraSystem(cameraSystem),
-	m_renderThread(&RayTracer::updateRenderThread, this)
+	m_world(4),
+	m_renderThreadActive(true),
+	m_isRenderingEnabled(true)
 {
-	m_smallBuffer.init(300, 150);
-	m_bigBuffer.init(1920, 1080);
-
-	m_buffer = &m_smallBuffer;
+	m_buffer.init(300, 150);
 
 	createSceneOne(m_world);
 	//createSceneFromBook(m_world);
 
 	using std::placeholders::_1;
 	m_cameraSystem.connectCameraChangedEventHandler(std::bind(&RayTracer::onCameraChanged, this, _1));
+
+	// Only once the scene exists, as the thread starts rendering right away.
+	clear();
+	m_renderThread = std::thread(&RayTracer::updateRenderThread, this);
 }
 
 RayTracer::~RayTracer()
 {
 	m_renderThreadActive = false;
+	wakeRenderThread();
 	m_renderThread.join();
 }
 
 void RayTracer::createSceneOne(HitableList& world, bool loadBunny)
 {
-	Camera& camera = m_cameraSystem.getCurrentCamera();
+	rae::createSceneOne(world, m_cameraSystem.getCurrentCamera(), loadBunny);
+	buildTree(world);
+}
 
-	camera.setFieldOfViewDeg(44.6f);
-
-	//camera.setPosition(vec3(0.698890f, 1.275992f, 6.693169f));
-	//camera.setYaw(Math::toRadians(188.0f));
-	//camera.setPitch(Math::toRadians(-7.744f));
-	//camera.setAperture(0.3f);
-	//camera.setFocusDistance(7.6f);
-
-	camera.setPosition(vec3(-0.16f, 2.9664f, 14.8691f));
-	camera.setYaw(Math::toRadians(178.560333f));
-	camera.setPitch(Math::toRadians(-10.8084f));
-	camera.setAperture(0.07f);
-	camera.setFocusDistance(14.763986f);
-
-	// A big light
-	world.add(
-		new Sphere(vec3(0.0f, 6.0f, -1.0f), 2.0f,
-		new Light(vec3(4.0f, 4.0f, 4.0f)))
-		);
-
-	// A small light
-	world.add(
-		new Sphere(vec3(3.85, 2.3, -0.15f), 0.2f,
-		new Light(vec3(16.0f, 16.0f, 16.0f)))
-		);
-
-	// A ball
-	world.add(
-		new Sphere(vec3(0, 0.3, -2), 0.5f,
-		new Lambertian(vec3(0.8f, 0.3f, 0.3f)))
-		);
-	// The planet
-	world.add(
-		new Sphere(vec3(0, -100.5f, -1), 100.0f,
-		new Lambertian(vec3(0.0f, 0.7f, 0.8f)))
-		);
-	
-	// Metal balls
-	world.add(
-		new Sphere(vec3(1, 0, 0), 0.5f,
-		new Metal(vec3(0.8f, 0.6f, 0.2f), /*roughness*/0.0f))
-		);
-	world.add(
-		new Sphere(vec3(-1.5f, 0.65f, 0.5), 0.4f,
-		new Metal(vec3(0.8f, 0.4f, 0.8f), /*roughness*/0.3f))
-		);
-	// Dielectric, glass ball
-	world.add(
-		new Sphere(vec3(-1, 0, 1), 0.5f,
-		new Dielectric(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f))
-		);
-	world.add(
-		new Sphere(vec3(-3.15f, 0.1f, -5), 0.6f,
-		new Lambertian(vec3(0.05f, 0.2f, 0.8f)))
-		);
-
-	///////////////////
-
-	auto bunny = new Mesh();
-	if (loadBunny)
-		bunny->loadModel("./data/models/bunny.obj");
-	else bunny->generateBox();
-
-	world.add(bunny);
-
-	m_tree.init(world.list(), 0, 0);
-}
-
-void RayTracer::createSceneFromBook(HitableList& list)
+void RayTracer::createSceneFromBook(HitableList& world)
 {
-	Camera& camera = m_cameraSystem.getCurrentCamera();
+	rae::createSceneFromBook(world, m_cameraSystem.getCurrentCamera());
+	buildTree(world);
+}
+
+void RayTracer::createSceneInstances(HitableList& world)
+{
+	rae::createSceneInstances(world, m_cameraSystem.getCurrentCamera(), /*loadBunny*/true);
+	buildTree(world);
+}
+
+void RayTracer::buildTree(HitableList& world)
+{
+	m_tree.build(world.list());
+	m_materialTable.bind(world.list());
+	m_pathTracer.findLights(world.list());
+
+	const BvhStats& stats = m_tree.stats();
+	LOG_F(INFO, "Bvh built in %f ms. Nodes: %i, max depth: %i, average leaf size: %f, SAH cost: %f",
+		stats.buildTimeMs, stats.nodeCount, stats.maxDepth, stats.averageLeafSize, stats.sahCost);
+}
 
-	camera.setPosition(vec3(16.857f, 2.0f, 6.474f));
-	camera.setYaw(Math::toRadians(247.8f));
-	camera.setPitch(Math::toRadians(-4.762f));
-	camera.setAperture(0.1f);
-	camera.setFocusDistance(17.29f);
+void RayTracer::setEntityTables(const EntityTables& tables)
+{
+	m_entityTables = tables;
+}
 
-	list.add( new Sphere(vec3(0,-1000,0), 1000, new Lambertian(vec3(0.5, 0.5, 0.5))) );
+void RayTracer::showScene(int number)
+{
+	if (number < 1 || number > 5)
+		return;
 
-	for (int a = -11; a < 11; a++)
+	if (number == 5 && m_entityTables.isValid() == false)
 	{
-		for (int b = -11; b < 11; b++)
+		LOG_F(ERROR, "No entities to show.");
+		return;
+	}
+
+	// Makes the render thread drop its pass, and keeps it from starting a new one.
+	m_isSceneChanging = true;
+	{
+		std::lock_guard<std::mutex> lock(m_renderMutex);
+		clearWorld();
+
+		if (number == 1)
+			createSceneOne(m_world, false);
+		else if (number == 2)
+			createSceneOne(m_world, true);
+		else if (number == 3)
+			createSceneFromBook(m_world);
+		else if (number == 4)
+			createSceneInstances(m_world);
+		else
 		{
-			float choose_mat = getRandom();
-			vec3 center(a + 0.9f * getRandom(), 0.2f, b + 0.9f * getRandom());
-			if ((center-vec3(4,0.2,0)).length() > 0.9f)
-			{ 
-				if (choose_mat < 0.8f)
-				{
-					// diffuse
-					list.add( new Sphere(center, 0.2f, new Lambertian(vec3( getRandom()*getRandom(), getRandom()*getRandom(), getRandom()*getRandom()))));
-				}
-				else if (choose_mat < 0.95f)
-				{
-					// metal
-					list.add( new Sphere(center, 0.2f,
-							new Metal(vec3(0.5f*(1.0f + getRandom()), 0.5f*(1.0f + getRandom()), 0.5f*(1.0f + getRandom())), /*roughness*/ 0.5f*getRandom())));
-				}
-				else
-				{
-					// glass
-					list.add( new Sphere(center, 0.2f, new Dielectric(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f)) );
-				}
-			}
+			m_isEntityScene = true;
+			syncEntityScene();
 		}
 	}
+	m_isSceneChanging = false;
 
-	list.add( new Sphere(vec3(0, 1, 0), 1.0, new Dielectric(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f)) );
-	list.add( new Sphere(vec3(-4, 1, 0), 1.0, new Lambertian(vec3(0.0, 0.2, 0.9))) );
-	list.add( new Sphere(vec3(4, 1, 0), 1.0, new Metal(vec3(0.7, 0.6, 0.5), 0.0)) );
-
-	m_tree.init(list.list(), 0, 0);
+	m_cameraSystem.setNeedsUpdate();
+	clear(); // Also wakes up the render thread.
 }
 
-void RayTracer::showScene(int number)
+void RayTracer::syncEntityScene()
 {
-	if (number == 1)
+	if (m_isEntitySceneStale)
 	{
-		clearScene();
-		createSceneOne(m_world, false);
+		m_entityScene.clear();
+		m_isEntitySceneStale = false;
 	}
 
-	if (number == 2)
+	const EntitySyncStats stats = m_entityScene.sync(m_entityTables);
+	// The updated instances can have new materials.
+	m_materialTable.bind(m_entityScene.hitables());
+	// Only the top level, the meshes keep their trees. Moved entities are refitted, which is
+	// what animated ones need every frame.
+	if (stats.isRebuildNeeded() || m_tree.isEmpty())
+	{
+		m_tree.build(m_entityScene.hitables());
+		m_pathTracer.findLights(m_entityScene.hitables());
+		LOG_F(INFO, "Entities synced: %i added, %i updated, %i removed. Top level built in %f ms.",
+			stats.addedCount, stats.updatedCount, stats.removedCount, m_tree.stats().buildTimeMs);
+	}
+	else if (stats.isChanged())
 	{
-		clearScene();
-		createSceneOne(m_world, true);
+		// Rebuilds by itself when the refits have made the tree too slow.
+		m_tree.update();
 	}
+}
 
-	if (number == 3)
+void RayTracer::updateEntityScene()
+{
+	if (m_isEntityScene == false
+		|| (m_isEntitySceneStale == false && m_entityScene.isSyncNeeded(m_entityTables) == false))
+		return;
+
+	m_isSceneChanging = true;
 	{
-		clearScene();
-		createSceneFromBook(m_world);
+		std::lock_guard<std::mutex> lock(m_renderMutex);
+		syncEntityScene();
 	}
+	m_isSceneChanging = false;
+
+	requestClear();
 }
 
 void RayTracer::clearScene()
 {
-	m_world.clear();
+	m_isSceneChanging = true;
+	{
+		std::lock_guard<std::mutex> lock(m_renderMutex);
+		clearWorld();
+	}
+	m_isSceneChanging = false;
+
 	m_cameraSystem.setNeedsUpdate();
 	clear();
 }
 
+void RayTracer::clearWorld()
+{
+	m_tree.clear();
+	m_pathTracer.clearLights();
+	m_world.clear();
+	m_materialTable.clear();
+	m_entityScene.clear();
+	m_isEntityScene = false;
+	m_isEntitySceneStale = false;
+}
+
 void RayTracer::onCameraChanged(const Camera& camera)
 {
 	if (camera.shouldWeAutoFocus())
 		autoFocus();
 
-	requestClear();
+	m_isCameraMoving = true;
+	if (m_isReprojection)
+		requestReprojection();
+	else requestClear();
 }
 
 void RayTracer::requestClear()
@@ -200,24 +226,94 @@ void RayTracer::requestClear()
 	m_requestClear = true;
 }
 
-void RayTracer::clear()
+void RayTracer::requestReprojection()
 {
-	std::lock_guard<std::mutex> lock(m_bufferMutex);
-	m_frameReady = false;
-	m_buffer->clear();
-	m_currentSample = 0;
+	m_requestReprojection = true;
+}
+
+void RayTracer::clear(bool isHistoryKept)
+{
+	// Stays set until the render thread clears, even if a later clear would keep the history.
+	if (isHistoryKept == false)
+		m_isHistoryDiscarded = true;
+
+	// Published before the request, so the render thread always starts over with this camera.
+	m_cameraSnapshots.back() = m_cameraSystem.getCurrentCamera();
+	m_cameraSnapshots.publish();
+	m_renderWidth = std::max(1, m_buffer.width() / m_renderDivider);
+	m_renderHeight = std::max(1, m_buffer.height() / m_renderDivider);
+	m_isClearPending = true;
+	wakeRenderThread();
+
 	m_totalRayTracingTime = -1.0;
 	m_startTime = -1.0f;
 }
 
+void RayTracer::clearAccumulation()
+{
+	const bool isReprojected = m_isHistoryDiscarded.exchange(false) == false && m_accumulation.width() > 0;
+	// What the accumulated samples were rendered with.
+	const Camera historyCamera = m_cameraSnapshots.front();
+	m_cameraSnapshots.update();
+
+	if (isReprojected)
+		std::swap(m_accumulation, m_history);
+
+	const int width = m_renderWidth;
+	const int height = m_renderHeight;
+	if (m_accumulation.width() != width || m_accumulation.height() != height)
+	{
+		m_accumulation.init(width, height);
+	}
+	else m_accumulation.clear();
+
+	if (m_tiles.width() != width || m_tiles.height() != height)
+	{
+		m_tiles.init(width, height);
+		m_tileVersions.assign(m_tiles.tileCount(), 0);
+		m_tileColors.assign(width * height, Color3(0.0f, 0.0f, 0.0f));
+	}
+	else
+	{
+		// All the tiles have changed.
+		for (int& version : m_tileVersions)
+		{
+			version++;
+		}
+	}
+
+	m_rayStats.clear();
+	if (RayStats::IsEnabled)
+		m_pixelStats.assign(width * height, PixelRayStats());
+
+	m_reprojectedPixelCount = 0;
+	if (isReprojected)
+	{
+		m_reprojectedPixelCount = m_reprojector.reproject(m_history, historyCamera, m_tree,
+			m_cameraSnapshots.front(), m_accumulation);
+	}
+
+	m_convergedPixelCount = 0;
+	m_maxPixelSampleCount = 0;
+	m_currentSample = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_publishMutex);
+		for (int tileIndex = 0; tileIndex < m_tiles.tileCount(); ++tileIndex)
+		{
+			snapshotTile(tileIndex);
+		}
+	}
+	publishFrame();
+}
+
 void RayTracer::setNanoVG(NVGcontext* nanoVG)
 {
 	assert(nanoVG != nullptr);
 
 	m_nanoVG = nanoVG;
 
-	m_smallBuffer.createImage(m_nanoVG);
-	m_bigBuffer.createImage(m_nanoVG);
+	m_buffer.createImage(m_nanoVG);
 }
 
 std::string toString(const HitRecord& record)
@@ -241,60 +337,41 @@ void RayTracer::autoFocus()
 	}
 }
 
-vec3 RayTracer::rayTrace(const Ray& ray, int depth)
+void RayTracer::updatePathTracer()
 {
-	Camera& camera = m_cameraSystem.getCurrentCamera();
-	HitRecord record;
-	if (m_tree.hit(ray, 0.001f, rayMaxLength(), record))
-	{
-		// Visualize focus distance with a line
-		if (m_isVisualizeFocusDistance)
-		{
-			float hitDistance = glm::length(record.point - camera.position());
-			if (Utils::isEqual(camera.focusDistance(), hitDistance, 0.01f) == true)
-			{
-				return vec3(0,1,1); // cyan line
-			}
-		}
-
-		// Normal raytracing
-		if (isFastMode() == false)
-		{
-			Ray scattered;
-			vec3 attenuation;
-			vec3 emitted = record.material->emitted(record.point);
-
-			if (depth < m_bouncesLimit && record.material->scatter(ray, record, attenuation, scattered))
-			{
-				return emitted + attenuation * rayTrace(scattered, depth + 1);
-			}
-			else
-			{
-				return emitted;
-			}
-		}
-		else // FastMode returns just the material color
-		{
-			return record.material->color3();
-		}
-	}
-	return sky(ray);
+	m_pathTracer.setWorld(&m_tree);
+	m_pathTracer.setMaterials(&m_materialTable);
+	m_pathTracer.setBouncesLimit(m_bouncesLimit);
+	m_pathTracer.setMaxRayLength(rayMaxLength());
+	m_pathTracer.setFastMode(isFastMode());
+	m_pathTracer.setLightSampling(m_isLightSampling);
+	m_pathTracer.setFocusCamera(m_isVisualizeFocusDistance ? &m_cameraSnapshots.front() : nullptr);
 }
 
-vec3 RayTracer::sky(const Ray& ray)
+void RayTracer::cycleSampler()
 {
-	vec3 unitDirection = glm::normalize(ray.direction());
-	float t = 0.5f * (unitDirection.y + 1.0f);
-	//return (1.0f - t) * vec3(0.3f, 0.4f, 1.0f) + t * vec3(0.7f, 0.8f, 1.0f);
-	return (1.0f - t) * vec3(0.0f, 0.0f, 0.0f) + t * vec3(0.05f, 0.05f, 0.05f);
+	m_samplerType = SamplerType((int(m_samplerType.load()) + 1) % int(SamplerType::Count));
+	requestClear();
 }
 
 //#define RENDER_ALL_AT_ONCE
 
 UpdateStatus RayTracer::update()
 {
+	if (m_isRenderingEnabled != bool(m_isEnabled))
+	{
+		m_isRenderingEnabled = bool(m_isEnabled);
+		wakeRenderThread();
+	}
+
 	if (!m_isEnabled)
+	{
+		// The updated flags are cleared every frame, so the changes until then would be missed.
+		m_isEntitySceneStale = m_isEntityScene;
 		return UpdateStatus::Disabled;
+	}
+
+	updateEntityScene();
 
 	/*
 	Old time based switch buffers system:
@@ -328,23 +405,39 @@ UpdateStatus RayTracer::update()
 		}
 	#else
 
-		// Hopefully temporary: Render first frame always on main thread.
-		if (m_currentSample == 0)
-		{
-			renderSamples();
-		}
-
-		if (m_frameReady == true)
+		if (m_frames.update())
 		{
+			const RenderFrame& frame = m_frames.front();
+			showFrame(frame);
 			updateImageBuffer();
-			m_frameReady = false;
+
+			if (frame.sampleTimeMs > 0.0)
+			{
+				m_sampleTimeMs = m_sampleTimeMs > 0.0 ? 0.5 * (m_sampleTimeMs + frame.sampleTimeMs) : frame.sampleTimeMs;
+			}
 		}
 	#endif
 
+	if (m_isDynamicResolution && m_isCameraMoving)
+		m_renderDivider = movingRenderDivider(); // Takes effect in the clear just below.
+	m_isCameraMoving = false;
+
 	if (m_requestClear)
 	{
 		clear();
 		m_requestClear = false;
+		m_requestReprojection = false;
+	}
+	else if (m_requestReprojection)
+	{
+		clear(/*isHistoryKept*/true);
+		m_requestReprojection = false;
+	}
+	else if (isRefinable(m_frames.front()))
+	{
+		// The camera hasn't moved, so all the samples are still valid at the higher resolution.
+		m_renderDivider /= 2;
+		clear(/*isHistoryKept*/true);
 	}
 
 	m_totalRayTracingTime = m_time.time() - m_startTime;
@@ -352,29 +445,103 @@ UpdateStatus RayTracer::update()
 	return UpdateStatus::Changed;
 }
 
+int RayTracer::movingRenderDivider() const
+{
+	// Until the first pass has been measured.
+	if (m_sampleTimeMs <= 0.0)
+		return MaxRenderDivider;
+
+	for (int divider = 1; divider < MaxRenderDivider; divider *= 2)
+	{
+		const double pixelCount = double(m_buffer.width() / divider) * double(m_buffer.height() / divider);
+		if (pixelCount * m_sampleTimeMs <= 1000.0 * m_frameTimeBudget)
+			return divider;
+	}
+	return MaxRenderDivider;
+}
+
+bool RayTracer::isRefinable(const RenderFrame& frame) const
+{
+	return m_isDynamicResolution
+		&& m_renderDivider > 1
+		&& frame.width == m_renderWidth
+		&& frame.height == m_renderHeight
+		&& frame.passCount > 0;
+}
+
 void RayTracer::updateRenderThread()
 {
-	while (m_renderThreadActive)
+	while (true)
 	{
-		if (m_buffer && m_frameReady == false && m_currentSample > 0)
 		{
-			std::lock_guard<std::mutex> lock(m_bufferMutex);
-			renderSamples();
+			std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+			m_wakeUp.wait(lock, [this]()
+			{
+				return m_renderThreadActive == false || hasRenderWork();
+			});
 		}
+
+		if (m_renderThreadActive == false)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_renderMutex);
+
+		if (m_isClearPending.exchange(false))
+			clearAccumulation();
+
+		if (m_isResolvePending.exchange(false))
+			publishFrame();
+
+		if (m_isRenderingEnabled && isRenderFinished() == false)
+			renderSamples();
 	}
 }
 
+void RayTracer::wakeRenderThread()
+{
+	{
+		// Taking the lock orders this with the render thread checking for work just before it
+		// sleeps, so the wakeup is not lost.
+		std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+	}
+	m_wakeUp.notify_one();
+}
+
+bool RayTracer::hasRenderWork()
+{
+	if (m_isSceneChanging)
+		return false;
+
+	if (m_isClearPending || m_isResolvePending)
+		return true;
+
+	return m_isRenderingEnabled && isRenderFinished() == false;
+}
+
 void RayTracer::updateDebugTexts()
 {
 	Camera& camera = m_cameraSystem.getCurrentCamera();
+	const RenderFrame& frame = m_frames.front();
 
-	g_debugSystem->showDebugText("Samples: " + std::to_string(m_currentSample));
+	g_debugSystem->showDebugText("Samples: " + std::to_string(frame.passCount));
 
 	if (m_samplesLimit > 0)
 	{
 		g_debugSystem->showDebugText("/" + std::to_string(m_samplesLimit));
 	}
 
+	g_debugSystem->showDebugText("Resolution: " + std::to_string(m_renderWidth) + "x" + std::to_string(m_renderHeight)
+		+ (m_isDynamicResolution ? ", dynamic" : ""));
+
+	g_debugSystem->showDebugText("Tiles: " + std::to_string(frame.finishedTileCount)
+		+ "/" + std::to_string(frame.tileCount));
+
+	if (m_isEntityScene)
+	{
+		g_debugSystem->showDebugText("Entities: " + std::to_string(m_entityScene.instanceCount())
+			+ ", meshes: " + std::to_string(m_entityScene.meshCount()));
+	}
+
 	g_debugSystem->showDebugText("Time: " + std::to_string(m_totalRayTracingTime) + " s");
 
 	g_debugSystem->showDebugText("Position: "
@@ -392,6 +559,44 @@ void RayTracer::updateDebugTexts()
 	g_debugSystem->showDebugText(camera.isContinuousAutoFocus() ? "Autofocus ON" : "Autofocus OFF");
 	g_debugSystem->showDebugText("Aperture: " + std::to_string(camera.aperture()));
 	g_debugSystem->showDebugText("Bounces: " + std::to_string(m_bouncesLimit));
+	g_debugSystem->showDebugText("Sampler: " + toString(m_samplerType));
+	g_debugSystem->showDebugText(m_isLightSampling ? "Light sampling ON" : "Light sampling OFF");
+
+	if (m_isAdaptiveSampling)
+	{
+		const int pixelCount = std::max(1, frame.width * frame.height);
+		g_debugSystem->showDebugText("Adaptive sampling ON, noise threshold: " + std::to_string(m_noiseThreshold)
+			+ ", converged: " + std::to_string(100 * frame.convergedPixelCount / pixelCount) + "%");
+	}
+	else g_debugSystem->showDebugText("Adaptive sampling OFF");
+
+	if (m_timeBudget > 0.0)
+		g_debugSystem->showDebugText("Time budget: " + std::to_string(m_timeBudget) + " s");
+
+	if (m_isDenoising)
+		g_debugSystem->showDebugText("Denoiser ON: " + std::to_string(frame.denoiseTimeMs) + " ms");
+	else g_debugSystem->showDebugText("Denoiser OFF");
+
+	if (m_isReprojection)
+	{
+		const int pixelCount = std::max(1, frame.width * frame.height);
+		g_debugSystem->showDebugText("Reprojection ON, reused: " + std::to_string(100 * frame.reprojectedPixelCount / pixelCount)
+			+ "%, " + std::to_string(frame.reprojectionTimeMs) + " ms");
+	}
+	else g_debugSystem->showDebugText("Reprojection OFF");
+
+	if (m_displayMode != DisplayMode::Color)
+		g_debugSystem->showDebugText("Showing " + toString(m_displayMode) + ", max: " + std::to_string(frame.maxHeatmapValue));
+
+	if (RayStats::IsEnabled)
+	{
+		const RayStats& stats = frame.rayStats;
+		g_debugSystem->showDebugText("Per sample: BVH nodes: " + std::to_string(stats.average(stats.bvhNodeCount))
+			+ ", AABB tests: " + std::to_string(stats.average(stats.aabbTestCount))
+			+ ", spheres: " + std::to_string(stats.average(stats.sphereTestCount))
+			+ ", triangles: " + std::to_string(stats.average(stats.triangleTestCount))
+			+ ", path length: " + std::to_string(stats.average(stats.bounceCount)));
+	}
 
 	g_debugSystem->showDebugText("Debug hit pos: "
 		+ std::to_string(debugHitRecord.point.x) + ", "
@@ -407,17 +612,33 @@ void RayTracer::updateDebugTexts()
 
 void RayTracer::toggleBufferQuality()
 {
+	if (m_buffer.width() < 1920)
 	{
-		std::lock_guard<std::mutex> lock(m_bufferMutex);
-		if (m_buffer == &m_smallBuffer)
-		{
-			m_buffer = &m_bigBuffer;
-		}
-		else m_buffer = &m_smallBuffer;
+		setResolution(1920, 1080);
 	}
+	else setResolution(300, 150);
+}
+
+void RayTracer::setResolution(int width, int height)
+{
+	m_buffer.deleteImage(m_nanoVG);
+	m_buffer.init(width, height);
+	if (m_nanoVG)
+		m_buffer.createImage(m_nanoVG);
+
 	clear();
 }
 
+void RayTracer::toggleDynamicResolution()
+{
+	m_isDynamicResolution = !m_isDynamicResolution;
+	if (m_isDynamicResolution == false && m_renderDivider > 1)
+	{
+		m_renderDivider = 1;
+		clear(/*isHistoryKept*/true);
+	}
+}
+
 float RayTracer::rayMaxLength()
 {
 	if (isFastMode() == false)
@@ -427,50 +648,43 @@ float RayTracer::rayMaxLength()
 
 void RayTracer::plusBounces(int delta)
 {
-	m_bouncesLimit += delta;
-	m_bouncesLimit = std::max(0, m_bouncesLimit);
-	m_bouncesLimit = std::min(5000, m_bouncesLimit);
+	m_bouncesLimit = std::min(5000, std::max(0, m_bouncesLimit + delta));
 }
 
 void RayTracer::minusBounces(int delta)
 {
-	m_bouncesLimit -= delta;
-	m_bouncesLimit = std::max(0, m_bouncesLimit);
-	m_bouncesLimit = std::min(5000, m_bouncesLimit);
+	m_bouncesLimit = std::min(5000, std::max(0, m_bouncesLimit - delta));
 }
 
 void RayTracer::renderAllAtOnce()
 {
-	// timings for 100 samples at 500x250:
-	// 14.791584 s
-	// 14.715808 s
-	// 14.710577 s
+	// For timings, run rae_benchmark from the bin directory.
 
 	if (m_currentSample < m_allAtOnceSamplesLimit)
 	{
 		Camera& camera = m_cameraSystem.getCurrentCamera();
 
 		// Parallel was about 3.6 times faster here. From 48 seconds to 13 seconds with a very low resolution and sample count.
-		parallel_for(0, m_buffer->height(), [&](int y)
+		updatePathTracer();
+
+		parallel_for(0, m_buffer.height(), [&](int y)
 		{
-			for (int x = 0; x < m_buffer->width(); ++x)
+			std::unique_ptr<Sampler> sampler = createSampler(m_samplerType, m_seed);
+			for (int x = 0; x < m_buffer.width(); ++x)
 			{
 				vec3 color;
 
 				for (int sample = 0; sample < m_allAtOnceSamplesLimit; sample++)
 				{
-					float u = float(x + drand48()) / float(m_buffer->width());
-					float v = float(y + drand48()) / float(m_buffer->height());
-					
-					Ray ray = camera.getRay(u, v);
-					color += rayTrace(ray);
+					color += m_pathTracer.renderPixelSample(camera, *sampler, x, y,
+						m_buffer.width(), m_buffer.height(), sample);
 				}
 
 				color /= float(m_allAtOnceSamplesLimit);
 
-				m_buffer->setPixel(x, y, color);
+				m_buffer.setPixel(x, y, color);
 			}
-		});
+		}, /*grainSize*/1); // Rows vary a lot in cost, so let the pool balance them row by row.
 
 		m_currentSample = m_allAtOnceSamplesLimit;
 	}
@@ -483,50 +697,357 @@ void RayTracer::renderAllAtOnce()
 
 void RayTracer::renderSamples()
 {
-	// timings for 100 samples at 500x250:
-	// 15.426324 s
-	// 15.402015 s
-	// 15.347182 s
+	// For timings, run rae_benchmark from the bin directory.
 
-	if (m_samplesLimit == 0 || m_currentSample < m_samplesLimit)
+	if (isRenderFinished() == false)
 	{
-		Camera& camera = m_cameraSystem.getCurrentCamera();
+		const Camera& camera = m_cameraSnapshots.front();
+		const int width = m_accumulation.width();
+		const int height = m_accumulation.height();
+
+		if (m_currentSample == 0)
+			m_renderStartTime = std::chrono::steady_clock::now();
 
-		// Single threaded
-		//for (int j = 0; j < m_buffer->height; ++j)
-		// Parallel, about twice the performance
-		parallel_for(0, m_buffer->height(), [&](int y)
+		// With adaptive sampling the converged pixels are skipped, and their share of the
+		// samples of the pass goes to the others.
+		int samplesPerPixel = 1;
+		if (m_isAdaptiveSampling)
 		{
-			for (int x = 0; x < m_buffer->width(); ++x)
-			{
-				float u = float(x + drand48()) / float(m_buffer->width());
-				float v = float(y + drand48()) / float(m_buffer->height());
+			const int pixelCount = m_accumulation.width() * m_accumulation.height();
+			const int unconvergedCount = pixelCount - countConvergedPixels();
+			if (unconvergedCount == 0)
+				return;
+			samplesPerPixel = Utils::clamp(pixelCount / unconvergedCount, 1, MaxAdaptiveSamplesPerPass);
+		}
+
+		updatePathTracer();
+
+		// The denoiser and the heatmap need the whole pass, plain colors can be shown tile by tile.
+		const bool isShownByTile = m_displayMode == DisplayMode::Color && m_isDenoising == false;
 
-				Ray ray = camera.getRay(u, v);
-				vec3 color = rayTrace(ray);
+		// The first pass from the middle out, so that something shows up where the viewer looks.
+		// The later ones slowest tiles first, to keep all the threads busy until the end.
+		const TileOrder order = m_currentSample == 0 ? TileOrder::CenterOut : TileOrder::CostliestFirst;
 
-				//http://stackoverflow.com/questions/22999487/update-the-average-of-a-continuous-sequence-of-numbers-in-constant-time
-				// add to average
-				m_buffer->setPixel(x, y,
-					(float(m_currentSample) * m_buffer->getPixel(x, y) + color) / float(m_currentSample + 1));
+		std::atomic<int> renderedSampleCount(0);
+		auto passStart = std::chrono::steady_clock::now();
+
+		m_tiles.run(order, [&](int tileIndex)
+		{
+			if (isPassCancelled())
+				return;
+
+			int tileSampleCount = 0;
+			const Tile& tile = m_tiles.tile(tileIndex);
+			std::unique_ptr<Sampler> sampler = createSampler(m_samplerType, m_seed);
+			RayStats tileStart;
+			if (RayStats::IsEnabled)
+				tileStart = threadRayStats();
+			for (int y = tile.y; y < tile.y + tile.height; ++y)
+			{
+				for (int x = tile.x; x < tile.x + tile.width; ++x)
+				{
+					if (m_isAdaptiveSampling && isPixelConverged(x, y))
+						continue;
+
+					RayStats pixelStart;
+					if (RayStats::IsEnabled)
+						pixelStart = threadRayStats();
+					int pixelBounceCount = 0;
+					for (int i = 0; i < samplesPerPixel; ++i)
+					{
+						FirstHit firstHit;
+						int bounceCount = 0;
+						vec3 color = m_pathTracer.renderPixelSample(camera, *sampler, x, y,
+							width, height, m_accumulation.sampleCount(x, y), &firstHit, &bounceCount);
+						m_accumulation.addSample(x, y, color, firstHit);
+						pixelBounceCount += bounceCount;
+					}
+					tileSampleCount += samplesPerPixel;
+
+					if (RayStats::IsEnabled)
+					{
+						RayStats& stats = threadRayStats();
+						stats.bounceCount += pixelBounceCount;
+						stats.sampleCount += samplesPerPixel;
+						m_pixelStats[y * width + x].add(stats - pixelStart);
+					}
+				}
 			}
+
+			if (RayStats::IsEnabled)
+				m_rayStats.add(threadRayStats() - tileStart);
+			renderedSampleCount += tileSampleCount;
+			finishTile(tileIndex, isShownByTile);
 		});
-		
+
+		// Also from the tiles of a cancelled pass.
+		if (renderedSampleCount > 0)
+		{
+			std::chrono::duration<double, std::milli> passTime = std::chrono::steady_clock::now() - passStart;
+			m_lastSampleTimeMs = passTime.count() / double(renderedSampleCount);
+		}
+
+		if (isPassCancelled())
+			return;
+
 		m_currentSample++;
-		m_frameReady = true;
+		publishFrame();
+	}
+}
+
+bool RayTracer::isPixelConverged(int x, int y) const
+{
+	return m_accumulation.isConverged(x, y, m_noiseThreshold, MinAdaptiveSamples);
+}
+
+int RayTracer::countConvergedPixels()
+{
+	int convergedCount = 0;
+	int maxSampleCount = 0;
+	for (int y = 0; y < m_accumulation.height(); ++y)
+	{
+		for (int x = 0; x < m_accumulation.width(); ++x)
+		{
+			if (isPixelConverged(x, y))
+				convergedCount++;
+			maxSampleCount = std::max(maxSampleCount, m_accumulation.sampleCount(x, y));
+		}
+	}
+	m_convergedPixelCount = convergedCount;
+	m_maxPixelSampleCount = maxSampleCount;
+	return convergedCount;
+}
+
+bool RayTracer::isRenderFinished()
+{
+	if (m_samplesLimit > 0 && m_currentSample >= m_samplesLimit)
+		return true;
+
+	if (m_currentSample == 0)
+		return false;
+
+	if (m_timeBudget > 0.0)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_renderStartTime;
+		if (elapsed.count() >= m_timeBudget)
+			return true;
+	}
+
+	return m_isAdaptiveSampling
+		&& m_convergedPixelCount == m_accumulation.width() * m_accumulation.height();
+}
+
+void RayTracer::finishTile(int tileIndex, bool isPublished)
+{
+	std::lock_guard<std::mutex> lock(m_publishMutex);
+	snapshotTile(tileIndex);
+	m_tileVersions[tileIndex]++;
+	if (isPublished)
+	{
+		// Never the denoiser or the heatmap here, even if they were just turned on: they go over
+		// the whole image, which is too slow to do for every tile.
+		resolveToFrame(m_frames.back(), /*isPlainColor*/true);
+		m_frames.publish();
 	}
 }
 
+void RayTracer::snapshotTile(int tileIndex)
+{
+	const int width = m_accumulation.width();
+	const Tile& tile = m_tiles.tile(tileIndex);
+	for (int y = tile.y; y < tile.y + tile.height; ++y)
+	{
+		for (int x = tile.x; x < tile.x + tile.width; ++x)
+		{
+			m_tileColors[y * width + x] = m_accumulation.color(x, y);
+		}
+	}
+}
+
+void RayTracer::publishFrame()
+{
+	std::lock_guard<std::mutex> lock(m_publishMutex);
+	resolveToFrame(m_frames.back(), m_displayMode == DisplayMode::Color && m_isDenoising == false);
+	m_frames.publish();
+}
+
+void RayTracer::resolveToFrame(RenderFrame& frame, bool isPlainColor)
+{
+	const int width = m_accumulation.width();
+	const int height = m_accumulation.height();
+	if (frame.width != width || frame.height != height)
+	{
+		frame.width = width;
+		frame.height = height;
+		frame.colors.assign(width * height, Color3(0.0f, 0.0f, 0.0f));
+		frame.tileVersions.assign(m_tiles.tileCount(), -1);
+	}
+
+	const bool isHeatmap = isPlainColor == false && m_displayMode != DisplayMode::Color;
+	if (isHeatmap)
+	{
+		countConvergedPixels(); // Updates the max sample count.
+		float maxValue = 0.0f;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				maxValue = std::max(maxValue, heatmapValue(x, y));
+			}
+		}
+
+		const float scale = maxValue > 0.0f ? 1.0f / maxValue : 0.0f;
+		parallel_for(0, height, [&](int y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				frame.colors[y * width + x] = heatmapColor(heatmapValue(x, y) * scale);
+			}
+		});
+		std::fill(frame.tileVersions.begin(), frame.tileVersions.end(), -1);
+		frame.maxHeatmapValue = maxValue;
+	}
+	else if (isPlainColor == false)
+	{
+		m_denoiser.denoise(m_accumulation, frame.colors);
+		std::fill(frame.tileVersions.begin(), frame.tileVersions.end(), -1);
+	}
+	else
+	{
+		// The frame was last written two publishes ago, so only a few tiles have changed since.
+		// Never from m_accumulation, where the other threads may be rendering those tiles again.
+		for (int tileIndex = 0; tileIndex < m_tiles.tileCount(); ++tileIndex)
+		{
+			if (frame.tileVersions[tileIndex] == m_tileVersions[tileIndex])
+				continue;
+
+			const Tile& tile = m_tiles.tile(tileIndex);
+			for (int y = tile.y; y < tile.y + tile.height; ++y)
+			{
+				for (int x = tile.x; x < tile.x + tile.width; ++x)
+				{
+					frame.colors[y * width + x] = m_tileColors[y * width + x];
+				}
+			}
+			frame.tileVersions[tileIndex] = m_tileVersions[tileIndex];
+		}
+	}
+
+	frame.passCount = m_currentSample;
+	frame.finishedTileCount = m_tiles.finishedCount();
+	frame.tileCount = m_tiles.tileCount();
+	frame.convergedPixelCount = m_convergedPixelCount;
+	frame.maxPixelSampleCount = m_maxPixelSampleCount;
+	frame.denoiseTimeMs = m_denoiser.lastTimeMs();
+	frame.reprojectedPixelCount = m_reprojectedPixelCount;
+	frame.reprojectionTimeMs = m_reprojector.lastTimeMs();
+	frame.sampleTimeMs = m_lastSampleTimeMs;
+	frame.rayStats = m_rayStats.load();
+}
+
+float RayTracer::heatmapValue(int x, int y) const
+{
+	if (m_displayMode == DisplayMode::SampleCount)
+		return float(m_accumulation.sampleCount(x, y));
+
+	// The reprojected samples weren't counted, so these are per counted sample.
+	const PixelRayStats& stats = m_pixelStats[y * m_accumulation.width() + x];
+	if (stats.sampleCount == 0)
+		return 0.0f;
+
+	float count = 0.0f;
+	switch (m_displayMode)
+	{
+		case DisplayMode::BvhNodes: count = float(stats.bvhNodeCount); break;
+		case DisplayMode::AabbTests: count = float(stats.aabbTestCount); break;
+		case DisplayMode::PrimitiveTests: count = float(stats.primitiveTestCount); break;
+		case DisplayMode::PathLength: count = float(stats.bounceCount); break;
+		default: break;
+	}
+	return count / float(stats.sampleCount);
+}
+
+void RayTracer::toggleAdaptiveSampling()
+{
+	m_isAdaptiveSampling = !m_isAdaptiveSampling;
+	requestClear();
+}
+
+void RayTracer::toggleDenoising()
+{
+	m_isDenoising = !m_isDenoising;
+	m_isResolvePending = true;
+	wakeRenderThread();
+}
+
+void RayTracer::cycleDisplayMode()
+{
+	DisplayMode mode = DisplayMode::Color;
+	switch (m_displayMode)
+	{
+		case DisplayMode::Color: mode = DisplayMode::SampleCount; break;
+		case DisplayMode::SampleCount: mode = RayStats::IsEnabled ? DisplayMode::BvhNodes : DisplayMode::Color; break;
+		case DisplayMode::BvhNodes: mode = DisplayMode::AabbTests; break;
+		case DisplayMode::AabbTests: mode = DisplayMode::PrimitiveTests; break;
+		case DisplayMode::PrimitiveTests: mode = DisplayMode::PathLength; break;
+		case DisplayMode::PathLength: mode = DisplayMode::Color; break;
+	}
+	m_displayMode = mode;
+	m_isResolvePending = true;
+	wakeRenderThread();
+}
+
 void RayTracer::writeToPng(String filename)
 {
-	std::lock_guard<std::mutex> lock(m_bufferMutex);
-	m_buffer->writeToPng(filename);
+	m_buffer.writeToPng(filename);
+}
+
+void RayTracer::showFrame(const RenderFrame& frame)
+{
+	const int width = m_buffer.width();
+	const int height = m_buffer.height();
+	if (frame.width == 0 || frame.height == 0)
+		return;
+
+	if (frame.width == width && frame.height == height)
+	{
+		parallel_for(0, height, [&](int y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				m_buffer.setPixel(x, y, frame.colors[y * width + x]);
+			}
+		});
+		return;
+	}
+
+	// Bilinear, between the centers of the frame pixels.
+	const float scaleX = float(frame.width) / float(width);
+	const float scaleY = float(frame.height) / float(height);
+	parallel_for(0, height, [&](int y)
+	{
+		const float frameY = Utils::clamp((float(y) + 0.5f) * scaleY - 0.5f, 0.0f, float(frame.height - 1));
+		const int y0 = int(frameY);
+		const int y1 = std::min(y0 + 1, frame.height - 1);
+		const float ty = frameY - float(y0);
+		for (int x = 0; x < width; ++x)
+		{
+			const float frameX = Utils::clamp((float(x) + 0.5f) * scaleX - 0.5f, 0.0f, float(frame.width - 1));
+			const int x0 = int(frameX);
+			const int x1 = std::min(x0 + 1, frame.width - 1);
+			const float tx = frameX - float(x0);
+
+			const vec3 top = glm::mix(frame.colors[y0 * frame.width + x0], frame.colors[y0 * frame.width + x1], tx);
+			const vec3 bottom = glm::mix(frame.colors[y1 * frame.width + x0], frame.colors[y1 * frame.width + x1], tx);
+			m_buffer.setPixel(x, y, glm::mix(top, bottom, ty));
+		}
+	});
 }
 
 void RayTracer::updateImageBuffer()
 {
-	std::lock_guard<std::mutex> lock(m_bufferMutex);
-	m_buffer->update8BitImageBuffer(m_nanoVG);
+	m_buffer.update8BitImageBuffer(m_nanoVG);
 }
 
 void RayTracer::renderNanoVG(NVGcontext* vg, float x, float y, float w, float h)
@@ -4,28 +4,80 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 
 #include "nanovg.h"
 
 #include "rae/core/Types.hpp"
 #include "rae/core/ISystem.hpp"
+#include "rae/core/TripleBuffer.hpp"
 
 #include "rae/visual/Ray.hpp"
 #include "rae_ray/HitRecord.hpp"
 #include "rae_ray/Hitable.hpp"
 #include "rae_ray/HitableList.hpp"
-#include "rae_ray/BvhNode.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/Denoiser.hpp"
+#include "rae_ray/EntityScene.hpp"
+#include "rae_ray/MaterialTable.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/RayStats.hpp"
+#include "rae_ray/Reprojector.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/TileScheduler.hpp"
 
 #include "rae/image/ImageBuffer.hpp"
+#include "rae/visual/Camera.hpp"
 
 namespace rae
 {
 
 class Time;
 class CameraSystem;
-class Camera;
 class Material;
 
+enum class DisplayMode
+{
+	Color,
+	SampleCount, // Heatmap of the samples per pixel
+	// Heatmaps of the RayStats per sample. Only with RAE_RAY_STATS.
+	BvhNodes,
+	AabbTests,
+	PrimitiveTests,
+	PathLength
+};
+
+String toString(DisplayMode mode);
+
+// What the render thread has to show. Written by the render thread, read by the main thread.
+struct RenderFrame
+{
+	int width = 0;
+	int height = 0;
+	Array<Color3> colors;
+	// Which version of each tile the colors are from, so that a reused frame only needs the
+	// tiles that have changed since. -1 when the colors aren't the plain tile colors.
+	Array<int> tileVersions;
+
+	// For the debug texts.
+	int passCount = 0;
+	int finishedTileCount = 0;
+	int tileCount = 0;
+	int convergedPixelCount = 0;
+	int maxPixelSampleCount = 0;
+	double denoiseTimeMs = 0.0;
+	int reprojectedPixelCount = 0;
+	double reprojectionTimeMs = 0.0;
+	// How long a sample took on average in the last pass, for choosing the resolution.
+	double sampleTimeMs = 0.0;
+	// Since the last clear. All zeros without RAE_RAY_STATS.
+	RayStats rayStats;
+	// The largest value in the heatmap.
+	float maxHeatmapValue = 0.0f;
+};
+
 class RayTracer : public ISystem
 {
 public:
@@ -34,33 +86,55 @@ public:
 
 	String name() override { return "RayTracer"; }
 
+	// Scene 5 is the entities of the editor, kept in sync with their tables while it is shown.
+	void setEntityTables(const EntityTables& tables);
 	void showScene(int number);
 	void clearScene();
 
 	void createSceneOne(HitableList& world, bool loadBunny = false);
 	void createSceneFromBook(HitableList& list);
+	void createSceneInstances(HitableList& world);
+	void buildTree(HitableList& world);
+	// Called with the render mutex held.
+	void syncEntityScene();
+	void updateEntityScene();
 
 	UpdateStatus update() override;
 	void updateDebugTexts();
 
+	// The render thread works on its own accumulation buffer and a snapshot of the camera, and
+	// hands the finished tiles and passes over to the main thread through a triple buffer, so
+	// that neither of them ever waits for the other. It sleeps when there is nothing to render.
 	void updateRenderThread();
 
 	void renderAllAtOnce();
 	void renderSamples();
+	// Samples limit, time budget or, with adaptive sampling, every pixel converged.
+	bool isRenderFinished();
+	// Copies the latest frame from the render thread to the display buffer, scaled up if it was
+	// rendered at a lower resolution.
+	void showFrame(const RenderFrame& frame);
 	void updateImageBuffer();
 	void renderNanoVG(NVGcontext* vg,  float x, float y, float w, float h);
 	void setNanoVG(NVGcontext* nanoVG);
 
 	void autoFocus();
 
-	vec3 rayTrace(const Ray& ray, int depth = 0);
-	vec3 sky(const Ray& ray);
+	// Passes the current settings to the path tracer before a render pass.
+	void updatePathTracer();
 
 	void requestClear(); // Ask for buffer and rendering state to be cleared on start of next update.
-	void clear();
+	// Like requestClear, but keeps the samples that are still valid from the new camera.
+	void requestReprojection();
+	// Takes a snapshot of the camera, and has the render thread start over with it. If the history
+	// is kept, the render thread starts with the samples reprojected to the new camera.
+	void clear(bool isHistoryKept = false);
+	// Switches between a small and a full HD display resolution.
 	void toggleBufferQuality();
+	void setResolution(int width, int height);
 	bool isFastMode() { return m_isFastMode; }
 	void toggleFastMode() { m_isFastMode = !m_isFastMode; }
+	void toggleLightSampling() { m_isLightSampling = !m_isLightSampling; requestClear(); }
 	float rayMaxLength();
 
 	HitRecord debugHitRecord;
@@ -70,35 +144,150 @@ public:
 
 	void toggleVisualizeFocusDistance() { m_isVisualizeFocusDistance = !m_isVisualizeFocusDistance; }
 
-	ImageBuffer& imageBuffer() { return *m_buffer; }
+	ImageBuffer& imageBuffer() { return m_buffer; }
 	void writeToPng(String filename);
 
+	// Adaptive sampling spends the samples only on the pixels that haven't converged yet, and
+	// stops when all of them have. Converged means the relative error is below the noise threshold.
+	void toggleAdaptiveSampling();
+	bool isAdaptiveSampling() const { return m_isAdaptiveSampling; }
+	void setNoiseThreshold(float threshold) { m_noiseThreshold = threshold; wakeRenderThread(); }
+	// Stops rendering after this many seconds. Zero for no limit.
+	void setTimeBudget(double seconds) { m_timeBudget = seconds; wakeRenderThread(); }
+	// From the colors through the heatmaps. The RayStats heatmaps are skipped without RAE_RAY_STATS.
+	void cycleDisplayMode();
+	DisplayMode displayMode() const { return m_displayMode; }
+	// Filters the noise out of the displayed image, guided by the first hit albedo, normal and depth.
+	void toggleDenoising();
+	bool isDenoising() const { return m_isDenoising; }
+	// Camera moves keep the samples that are still valid, instead of starting over from nothing.
+	void toggleReprojection() { m_isReprojection = !m_isReprojection; }
+	bool isReprojection() const { return m_isReprojection; }
+
+	// While the camera moves, renders at the largest fraction of the display resolution that fits
+	// a pass in the frame time budget, down to 1/8. When it stops, doubles the resolution after
+	// every pass until it is back at full resolution.
+	void toggleDynamicResolution();
+	bool isDynamicResolution() const { return m_isDynamicResolution; }
+	void setFrameTimeBudget(double seconds) { m_frameTimeBudget = seconds; }
+	double frameTimeBudget() const { return m_frameTimeBudget; }
+
+	SamplerType samplerType() const { return m_samplerType; }
+	void setSamplerType(SamplerType type) { m_samplerType = type; requestClear(); }
+	void cycleSampler();
+
+	// Renders with the same seed give the same image, no matter how many threads render them.
+	void setSeed(uint64_t seed) { m_seed = seed; }
+	uint64_t seed() const { return m_seed; }
+
 	void plusBounces(int delta = 1);
 	void minusBounces(int delta = 1);
 
 	void onCameraChanged(const Camera& camera);
 
 protected:
+	bool isPixelConverged(int x, int y) const;
+	// Also updates the converged pixel and max sample counts.
+	int countConvergedPixels();
+
+	// Call after changing anything that hasRenderWork() depends on.
+	void wakeRenderThread();
+
+	// The render resolution divider for when the camera moves.
+	int movingRenderDivider() const;
+	// With dynamic resolution, when the current resolution has finished a pass and the camera stands still.
+	bool isRefinable(const RenderFrame& frame) const;
+
+	// The rest of these are for the render thread only.
+	bool hasRenderWork();
+	void clearAccumulation();
+	// A clear or a scene change is waiting, or the render thread is shutting down: the rest of
+	// the pass would be thrown away.
+	bool isPassCancelled() const { return m_isClearPending || m_isSceneChanging || m_renderThreadActive == false; }
+	void finishTile(int tileIndex, bool isPublished);
+	// Copies the accumulated colors of the tile to m_tileColors. Only by the thread that rendered
+	// the tile, or when no tiles are rendering, and under m_publishMutex.
+	void snapshotTile(int tileIndex);
+	// Writes the accumulated colors, or the heatmap, to the back frame and publishes it.
+	void publishFrame();
+	// Otherwise denoised, or the heatmap.
+	void resolveToFrame(RenderFrame& frame, bool isPlainColor);
+	// What the heatmap shows for the pixel, not yet scaled to the largest value.
+	float heatmapValue(int x, int y) const;
+	void clearWorld();
+
+	static const int MinAdaptiveSamples = 16;
+	static const int MaxAdaptiveSamplesPerPass = 16;
+	static const int MaxRenderDivider = 8;
 
 	bool m_isInfoText = true;
-	bool m_isFastMode = false;
-	bool m_isVisualizeFocusDistance = true;
+	// The atomic settings are changed by the main thread while the render thread reads them.
+	std::atomic<bool> m_isFastMode{false};
+	std::atomic<bool> m_isVisualizeFocusDistance{true};
+	std::atomic<bool> m_isLightSampling{true};
 
 	double m_switchTime = 5.0f; // time to switch to big buffer rendering in seconds
 
-	ImageBuffer m_smallBuffer;
-	ImageBuffer m_bigBuffer;
-	ImageBuffer* m_buffer = nullptr;
-	std::mutex m_bufferMutex;
-	std::atomic<bool> m_frameReady;
-
-	bool m_requestClear;
+	ImageBuffer m_buffer; // Main thread only.
+
+	bool m_isDynamicResolution = true;
+	double m_frameTimeBudget = 1.0 / 30.0;
+	// The display resolution divided by this is the render resolution.
+	int m_renderDivider = 1;
+	bool m_isCameraMoving = false;
+	double m_sampleTimeMs = 0.0; // Smoothed from the frames, main thread only.
+
+	// Held for a whole render pass. The main thread only takes it to change the scene.
+	std::mutex m_renderMutex;
+	std::atomic<bool> m_isSceneChanging;
+	std::atomic<bool> m_isClearPending;
+	std::atomic<bool> m_isResolvePending; // The display mode changed.
+	std::atomic<bool> m_isHistoryDiscarded; // The next clear can't reproject the old samples.
+	std::atomic<int> m_renderWidth;
+	std::atomic<int> m_renderHeight;
+	TripleBuffer<Camera> m_cameraSnapshots;
+	TripleBuffer<RenderFrame> m_frames;
+	// Between the render threads finishing tiles at the same time. Never taken by the main thread.
+	std::mutex m_publishMutex;
+
+	AccumulationBuffer m_accumulation;
+	AccumulationBuffer m_history; // The previous accumulation, while it is reprojected.
+	TileScheduler m_tiles;
+	Array<int> m_tileVersions;
+	// The colors of each tile as it was when it was last finished. The frames are written from
+	// these, as the other threads may be adding samples to m_accumulation at the same time.
+	Array<Color3> m_tileColors;
+
+	bool m_requestClear = false;
+	bool m_requestReprojection = false;
 
 	int m_allAtOnceSamplesLimit = 2000;
-	int m_samplesLimit = 0;
-	int m_bouncesLimit = 50;
+	std::atomic<int> m_samplesLimit{0};
+	std::atomic<int> m_bouncesLimit{50};
 	
 	int m_currentSample = 0;
+	std::atomic<uint64_t> m_seed{0};
+	std::atomic<SamplerType> m_samplerType{SamplerType::Sobol};
+
+	std::atomic<bool> m_isAdaptiveSampling{false};
+	std::atomic<float> m_noiseThreshold{0.02f};
+	std::atomic<double> m_timeBudget{0.0};
+	std::chrono::steady_clock::time_point m_renderStartTime;
+	int m_convergedPixelCount = 0;
+	int m_maxPixelSampleCount = 0;
+	std::atomic<DisplayMode> m_displayMode;
+
+	// Only counted with RAE_RAY_STATS. Since the last clear.
+	AtomicRayStats m_rayStats;
+	Array<PixelRayStats> m_pixelStats;
+
+	std::atomic<bool> m_isDenoising;
+	Denoiser m_denoiser;
+
+	bool m_isReprojection = true;
+	Reprojector m_reprojector;
+	int m_reprojectedPixelCount = 0;
+	double m_lastSampleTimeMs = 0.0; // Render thread only.
 	double m_totalRayTracingTime = -1.0;
 
 	// for renderAllAtOnce:
@@ -107,12 +296,22 @@ protected:
 	const Time& m_time;
 	CameraSystem& m_cameraSystem;
 	HitableList m_world;
-	BvhNode m_tree;
+	MaterialTable m_materialTable; // Of m_world or the entity scene.
+	EntityTables m_entityTables;
+	EntityScene m_entityScene;
+	bool m_isEntityScene = false;
+	bool m_isEntitySceneStale = false; // Changes might have been missed while disabled.
+	Bvh m_tree;
+	PathTracer m_pathTracer;
 
 	NVGcontext* m_nanoVG = nullptr;
 	NVGpaint m_imgPaint;
 
-	bool m_renderThreadActive = true;
+	std::atomic<bool> m_renderThreadActive;
+	// A copy of m_isEnabled, which isn't safe to read from the render thread.
+	std::atomic<bool> m_isRenderingEnabled;
+	std::mutex m_wakeUpMutex;
+	std::condition_variable m_wakeUp;
 	std::thread m_renderThread;
 };
 
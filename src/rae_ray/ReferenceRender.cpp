@@ -0,0 +1,78 @@
+#include "rae_ray/ReferenceRender.hpp"
+
+#include <cmath>
+#include <memory>
+
+#include "rae/core/Utils.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/PathTracer.hpp"
+
+using namespace rae;
+
+int64_t rae::accumulateSamples(const PathTracer& pathTracer, const Camera& camera, AccumulationBuffer& buffer,
+	int sampleCount, SamplerType samplerType, uint64_t seed)
+{
+	const int width = buffer.width();
+	const int height = buffer.height();
+	Array<int64_t> rowBounces(height, 0);
+
+	parallel_for(0, height, [&](int y)
+	{
+		std::unique_ptr<Sampler> sampler = createSampler(samplerType, seed);
+		for (int x = 0; x < width; ++x)
+		{
+			for (int sample = 0; sample < sampleCount; ++sample)
+			{
+				FirstHit firstHit;
+				int bounces = 0;
+				vec3 color = pathTracer.renderPixelSample(camera, *sampler, x, y, width, height, sample,
+					&firstHit, &bounces);
+				buffer.addSample(x, y, color, firstHit);
+				rowBounces[y] += bounces;
+			}
+		}
+	}, /*grainSize*/1);
+
+	int64_t bounceCount = 0;
+	for (int64_t bounces : rowBounces)
+	{
+		bounceCount += bounces;
+	}
+	return bounceCount;
+}
+
+Array<vec3> rae::bufferColors(const AccumulationBuffer& buffer)
+{
+	Array<vec3> result;
+	result.reserve(buffer.width() * buffer.height());
+	for (int y = 0; y < buffer.height(); ++y)
+	{
+		for (int x = 0; x < buffer.width(); ++x)
+		{
+			result.push_back(buffer.color(x, y));
+		}
+	}
+	return result;
+}
+
+double rae::rootMeanSquareError(const Array<vec3>& image, const Array<vec3>& reference, float maxValue)
+{
+	const vec3 maxColor(maxValue, maxValue, maxValue);
+	double sum = 0.0;
+	for (size_t i = 0; i < image.size(); ++i)
+	{
+		vec3 difference = glm::min(image[i], maxColor) - glm::min(reference[i], maxColor);
+		sum += glm::dot(difference, difference) / 3.0f;
+	}
+	return std::sqrt(sum / image.size());
+}
+
+vec3 rae::average(const Array<vec3>& image)
+{
+	vec3 sum;
+	for (const vec3& color : image)
+	{
+		sum += color;
+	}
+	return sum / float(image.size());
+}
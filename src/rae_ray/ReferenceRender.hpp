@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cfloat>
+#include <stdint.h>
+
+#include "rae/core/Types.hpp"
+#include "rae_ray/Sampler.hpp"
+
+namespace rae
+{
+
+class AccumulationBuffer;
+class Camera;
+class PathTracer;
+
+// Renders and image comparisons for measuring the ray tracer against a reference image,
+// shared by the tests and rae_benchmark.
+
+// Adds sampleCount samples to every pixel of the buffer, on the thread pool one row at a time.
+// Returns the number of bounces the samples took.
+int64_t accumulateSamples(const PathTracer& pathTracer, const Camera& camera, AccumulationBuffer& buffer,
+	int sampleCount, SamplerType samplerType = SamplerType::Sobol, uint64_t seed = 1);
+
+// The average colors of the buffer, row by row.
+Array<vec3> bufferColors(const AccumulationBuffer& buffer);
+
+// Both images are clamped to maxValue first. Clamping to 1 compares only the range that can be
+// shown, so that the error isn't all at the edges of the lights.
+double rootMeanSquareError(const Array<vec3>& image, const Array<vec3>& reference, float maxValue = FLT_MAX);
+
+vec3 average(const Array<vec3>& image);
+
+}
@@ -0,0 +1,77 @@
+#include "rae_ray/Reprojector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#include "rae/core/Utils.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Hitable.hpp"
+
+using namespace rae;
+
+int Reprojector::reproject(const AccumulationBuffer& history, const Camera& historyCamera,
+	const Hitable& world, const Camera& camera, AccumulationBuffer& target)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const int width = target.width();
+	const int height = target.height();
+	std::atomic<int> reusedCount(0);
+
+	// From a smaller image each old pixel is spread over several new ones, and gives each of them
+	// only its share of the samples.
+	const float sampleShare = std::min(1.0f,
+		float(history.width() * history.height()) / float(std::max(1, width * height)));
+
+	parallel_for(0, height, [&](int y)
+	{
+		int rowReusedCount = 0;
+		for (int x = 0; x < width; ++x)
+		{
+			Ray ray = camera.getExactRay((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+			HitRecord record;
+			const bool isHit = world.hit(ray, 0.001f, FLT_MAX, record);
+
+			// The sky only depends on the direction, so a miss looks it up as if it was infinitely far.
+			const vec3 point = isHit ? record.point : historyCamera.position() + ray.direction();
+			vec2 screen;
+			if (historyCamera.project(point, screen) == false
+				|| screen.x < 0.0f || screen.x >= 1.0f || screen.y < 0.0f || screen.y >= 1.0f)
+				continue;
+
+			const int historyX = std::min(int(screen.x * float(history.width())), history.width() - 1);
+			const int historyY = std::min(int(screen.y * float(history.height())), history.height() - 1);
+			if (history.sampleCount(historyX, historyY) == 0)
+				continue;
+
+			// Zero for the sky, shorter than one where some samples hit something else.
+			const vec3 historyNormal = history.normal(historyX, historyY);
+			float depth = 0.0f;
+			if (isHit)
+			{
+				if (glm::dot(historyNormal, record.normal) < m_minNormalCosine)
+					continue;
+
+				depth = record.t * glm::length(ray.direction());
+				const float planeDistance = std::abs(glm::dot(history.position(historyX, historyY) - point, record.normal));
+				if (planeDistance > m_planeTolerance * depth)
+					continue;
+			}
+			else if (historyNormal != vec3(0.0f, 0.0f, 0.0f))
+				continue;
+
+			const int share = std::max(1, int(sampleShare * float(history.sampleCount(historyX, historyY))));
+			target.setFromHistory(x, y, history, historyX, historyY, depth, std::min(share, m_maxHistorySamples));
+			rowReusedCount++;
+		}
+		reusedCount += rowReusedCount;
+	});
+
+	m_lastTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return reusedCount;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+class AccumulationBuffer;
+class Camera;
+class Hitable;
+
+// Keeps the samples of the pixels that are still valid after the camera has moved, so that the
+// image doesn't start over from nothing on every small move. For each new pixel the center ray
+// is traced to the first hit, which is then looked up in the old image. The old samples are
+// used only if they are of the same surface: close to the same plane, with a similar normal.
+// Misses reuse the old sky in the same direction. Everything else starts from zero samples.
+class Reprojector
+{
+public:
+	// Fills target, already sized and cleared for the new camera, with the valid samples of history
+	// rendered with historyCamera. The sizes may differ. Returns the number of pixels that kept their samples.
+	int reproject(const AccumulationBuffer& history, const Camera& historyCamera,
+		const Hitable& world, const Camera& camera, AccumulationBuffer& target);
+
+	// Keeping only a few of the old samples lets new samples soon fix what the checks didn't catch,
+	// like reflections that move with the camera.
+	void setMaxHistorySamples(int samples) { m_maxHistorySamples = samples; }
+	int maxHistorySamples() const { return m_maxHistorySamples; }
+	// How far the old hit may be from the plane of the new one, relative to the distance from the camera.
+	void setPlaneTolerance(float tolerance) { m_planeTolerance = tolerance; }
+	// The smallest cosine between the old and the new normal.
+	void setMinNormalCosine(float cosine) { m_minNormalCosine = cosine; }
+
+	// How long the last reproject() took.
+	double lastTimeMs() const { return m_lastTimeMs; }
+
+protected:
+	int m_maxHistorySamples = 8;
+	float m_planeTolerance = 0.02f;
+	float m_minNormalCosine = 0.9f;
+
+	double m_lastTimeMs = 0.0;
+};
+
+}
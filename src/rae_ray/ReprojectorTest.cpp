@@ -0,0 +1,113 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/ReferenceRender.hpp"
+#include "rae_ray/Reprojector.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/Sphere.hpp"
+
+using namespace rae;
+
+SCENARIO("Reprojector unittest", "[rae][Reprojector]")
+{
+	GIVEN( "a sphere on the ground rendered with a few samples" )
+	{
+		const int width = 64;
+		const int height = 32;
+		const int samples = 16;
+
+		HitableList world;
+		world.create<Sphere>(vec3(0.0f, 0.0f, 0.0f), 1.0f, world.createMaterial<Lambertian>(Color3(0.8f, 0.3f, 0.3f)));
+		world.create<Sphere>(vec3(0.0f, -101.0f, 0.0f), 100.0f, world.createMaterial<Lambertian>(Color3(0.5f, 0.5f, 0.5f)));
+
+		PathTracer pathTracer;
+		pathTracer.setWorld(&world);
+		pathTracer.setBouncesLimit(4);
+
+		Camera historyCamera(Math::toRadians(40.0f), float(width) / float(height), /*aperture*/0.0f, /*focusDistance*/5.0f);
+		historyCamera.setPosition(vec3(0.0f, 0.5f, -5.0f));
+		historyCamera.calculateFrustum();
+
+		AccumulationBuffer history;
+		history.init(width, height);
+		accumulateSamples(pathTracer, historyCamera, history, samples);
+
+		AccumulationBuffer target;
+		target.init(width, height);
+		Reprojector reprojector;
+
+		WHEN( "the camera hasn't moved" )
+		{
+			const int reusedCount = reprojector.reproject(history, historyCamera, world, historyCamera, target);
+
+			THEN( "nearly all the pixels keep their colors, with fewer samples" )
+			{
+				REQUIRE(reusedCount > width * height * 9 / 10);
+
+				bool isSameColor = true;
+				bool isLimited = true;
+				for (int y = 0; y < height; ++y)
+				{
+					for (int x = 0; x < width; ++x)
+					{
+						if (target.sampleCount(x, y) == 0)
+							continue;
+						if (glm::length(target.color(x, y) - history.color(x, y)) > 0.0001f)
+							isSameColor = false;
+						if (target.sampleCount(x, y) > reprojector.maxHistorySamples())
+							isLimited = false;
+					}
+				}
+				REQUIRE(isSameColor == true);
+				REQUIRE(isLimited == true);
+			}
+		}
+
+		WHEN( "the camera moves a little to the side" )
+		{
+			Camera camera = historyCamera;
+			camera.setPosition(vec3(0.2f, 0.5f, -5.0f));
+			camera.calculateFrustum();
+			const int reusedCount = reprojector.reproject(history, historyCamera, world, camera, target);
+
+			THEN( "most of the pixels are still valid" )
+			{
+				REQUIRE(reusedCount > width * height * 3 / 4);
+			}
+		}
+
+		WHEN( "the new image has twice the resolution" )
+		{
+			AccumulationBuffer larger;
+			larger.init(2 * width, 2 * height);
+			const int reusedCount = reprojector.reproject(history, historyCamera, world, historyCamera, larger);
+
+			THEN( "each old pixel gives a quarter of its samples to each of the four new ones" )
+			{
+				REQUIRE(reusedCount > 4 * width * height * 9 / 10);
+				REQUIRE(larger.sampleCount(width, height) == samples / 4);
+			}
+		}
+
+		WHEN( "a new sphere has appeared in front of the camera" )
+		{
+			world.create<Sphere>(vec3(0.0f, 0.5f, -3.0f), 0.3f, world.createMaterial<Lambertian>(Color3(0.3f, 0.8f, 0.3f)));
+			reprojector.reproject(history, historyCamera, world, historyCamera, target);
+
+			THEN( "the pixels it covers start over" )
+			{
+				REQUIRE(target.sampleCount(width / 2, height / 2) == 0);
+				REQUIRE(target.sampleCount(0, height / 2) > 0);
+			}
+		}
+	}
+}
+
+#endif
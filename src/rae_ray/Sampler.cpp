@@ -0,0 +1,295 @@
+#include "rae_ray/Sampler.hpp"
+
+#include <cmath>
+
+#include "rae/core/Random.hpp"
+#include "rae/core/Utils.hpp"
+
+using namespace rae;
+
+const int HaltonSampler::MaxDimensions;
+const int BlueNoiseSampler::TileSize;
+
+// The largest float below 1.
+static const float OneMinusEpsilon = 0.99999994f;
+
+String rae::toString(SamplerType type)
+{
+	switch (type)
+	{
+		case SamplerType::Random: return "Random";
+		case SamplerType::Halton: return "Halton";
+		case SamplerType::Sobol: return "Sobol";
+		case SamplerType::BlueNoise: return "Blue noise";
+		default: return "Unknown";
+	}
+}
+
+static float toUnitFloat(uint32_t value)
+{
+	return float(value >> 8) * (1.0f / 16777216.0f);
+}
+
+// Unique for images up to 65536 pixels wide.
+static int pixelIndex(int x, int y)
+{
+	return y * 65536 + x;
+}
+
+void Sampler::startPixelSample(int x, int y, int sampleIndex)
+{
+	m_x = x;
+	m_y = y;
+	m_sampleIndex = sampleIndex;
+	m_dimension = 0;
+	seedThreadRandom(m_seed, pixelIndex(x, y), sampleIndex);
+}
+
+vec2 Sampler::get2D()
+{
+	float first = get1D();
+	return vec2(first, get1D());
+}
+
+float RandomSampler::get1D()
+{
+	m_dimension++;
+	return getRandom();
+}
+
+static const int HaltonPrimes[HaltonSampler::MaxDimensions] =
+{
+	2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+	59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+};
+
+static double radicalInverse(int base, uint32_t index)
+{
+	const double inverseBase = 1.0 / base;
+	double factor = inverseBase;
+	double result = 0.0;
+	while (index > 0)
+	{
+		result += factor * (index % base);
+		index /= base;
+		factor *= inverseBase;
+	}
+	return result;
+}
+
+float HaltonSampler::get1D()
+{
+	const int dimension = m_dimension++;
+	if (dimension >= MaxDimensions)
+		return getRandom();
+
+	double rotation = toUnitFloat(uint32_t(hashRandomSeed(m_seed, pixelIndex(m_x, m_y), dimension)));
+	double value = radicalInverse(HaltonPrimes[dimension], uint32_t(m_sampleIndex)) + rotation;
+	if (value >= 1.0)
+		value -= 1.0;
+	return std::min(float(value), OneMinusEpsilon);
+}
+
+static uint32_t reverseBits(uint32_t value)
+{
+	value = (value << 16) | (value >> 16);
+	value = ((value & 0x00ff00ffu) << 8) | ((value & 0xff00ff00u) >> 8);
+	value = ((value & 0x0f0f0f0fu) << 4) | ((value & 0xf0f0f0f0u) >> 4);
+	value = ((value & 0x33333333u) << 2) | ((value & 0xccccccccu) >> 2);
+	value = ((value & 0x55555555u) << 1) | ((value & 0xaaaaaaaau) >> 1);
+	return value;
+}
+
+// A hash where every bit only depends on the bits below it.
+static uint32_t laineKarrasPermutation(uint32_t value, uint32_t seed)
+{
+	value ^= value * 0x3d20adeau;
+	value += seed;
+	value *= (seed >> 16) | 1u;
+	value ^= value * 0x05526c56u;
+	value ^= value * 0x53a22864u;
+	return value;
+}
+
+// Owen scrambling in base 2: every bit is flipped depending on the bits above it.
+static uint32_t nestedUniformScramble(uint32_t value, uint32_t seed)
+{
+	return reverseBits(laineKarrasPermutation(reverseBits(value), seed));
+}
+
+// The first dimension of Sobol is the van der Corput sequence.
+static uint32_t sobolFirst(uint32_t index)
+{
+	return reverseBits(index);
+}
+
+static uint32_t sobolSecond(uint32_t index)
+{
+	uint32_t result = 0;
+	for (uint32_t direction = 1u << 31; index != 0; index >>= 1, direction ^= direction >> 1)
+	{
+		if (index & 1u)
+			result ^= direction;
+	}
+	return result;
+}
+
+vec2 SobolSampler::getPair(bool secondValue)
+{
+	const int pair = m_dimension++;
+	const uint64_t hash = hashRandomSeed(m_seed, m_isScrambledPerPixel ? pixelIndex(m_x, m_y) : 0, pair);
+	const uint32_t shuffleSeed = uint32_t(hash);
+	const uint32_t scrambleSeed = uint32_t(hash >> 32);
+
+	const uint32_t index = nestedUniformScramble(uint32_t(m_sampleIndex), shuffleSeed);
+	const float first = toUnitFloat(nestedUniformScramble(sobolFirst(index), scrambleSeed));
+	if (secondValue == false)
+		return vec2(first, 0.0f);
+
+	const uint32_t secondSeed = laineKarrasPermutation(scrambleSeed, 0x9e3779b9u);
+	return vec2(first, toUnitFloat(nestedUniformScramble(sobolSecond(index), secondSeed)));
+}
+
+float SobolSampler::get1D()
+{
+	return getPair(false).x;
+}
+
+vec2 SobolSampler::get2D()
+{
+	return getPair(true);
+}
+
+double BlueNoiseSampler::blueNoise(int dimension) const
+{
+	const uint64_t hash = hashRandomSeed(m_seed, dimension);
+	const int offsetX = int(hash & (TileSize - 1));
+	const int offsetY = int((hash >> 16) & (TileSize - 1));
+
+	const Array<uint16_t>& ranks = tile();
+	const int tileX = (m_x + offsetX) & (TileSize - 1);
+	const int tileY = (m_y + offsetY) & (TileSize - 1);
+	return (ranks[tileY * TileSize + tileX] + 0.5) / double(TileSize * TileSize);
+}
+
+static float rotate(float value, double offset)
+{
+	double rotated = value + offset;
+	if (rotated >= 1.0)
+		rotated -= 1.0;
+	return std::min(float(rotated), OneMinusEpsilon);
+}
+
+float BlueNoiseSampler::get1D()
+{
+	const int pair = m_dimension;
+	return rotate(getPair(false).x, blueNoise(2 * pair));
+}
+
+vec2 BlueNoiseSampler::get2D()
+{
+	const int pair = m_dimension;
+	const vec2 value = getPair(true);
+	return vec2(rotate(value.x, blueNoise(2 * pair)), rotate(value.y, blueNoise(2 * pair + 1)));
+}
+
+// Void and cluster, simplified to only its last phase: each pixel in turn goes to the
+// largest void, the free pixel with the least Gaussian energy from the pixels before it.
+static Array<uint16_t> generateBlueNoiseTile(int size)
+{
+	const int count = size * size;
+	const float sigma = 1.5f;
+
+	Array<float> kernel(count);
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			// Wraps around, so that the tile can be repeated.
+			float dx = float(std::min(x, size - x));
+			float dy = float(std::min(y, size - y));
+			kernel[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+		}
+	}
+
+	Array<float> energy(count, 0.0f);
+	Array<bool> taken(count, false);
+	Array<uint16_t> ranks(count, 0);
+
+	for (int rank = 0; rank < count; ++rank)
+	{
+		int best = -1;
+		for (int i = 0; i < count; ++i)
+		{
+			if (taken[i] == false && (best == -1 || energy[i] < energy[best]))
+				best = i;
+		}
+
+		ranks[best] = uint16_t(rank);
+		taken[best] = true;
+
+		const int bestX = best % size;
+		const int bestY = best / size;
+		for (int y = 0; y < size; ++y)
+		{
+			const int kernelRow = ((y - bestY) & (size - 1)) * size;
+			for (int x = 0; x < size; ++x)
+			{
+				energy[y * size + x] += kernel[kernelRow + ((x - bestX) & (size - 1))];
+			}
+		}
+	}
+	return ranks;
+}
+
+const Array<uint16_t>& BlueNoiseSampler::tile()
+{
+	static const Array<uint16_t> ranks = generateBlueNoiseTile(TileSize);
+	return ranks;
+}
+
+std::unique_ptr<Sampler> rae::createSampler(SamplerType type, uint64_t seed)
+{
+	switch (type)
+	{
+		case SamplerType::Halton: return std::unique_ptr<Sampler>(new HaltonSampler(seed));
+		case SamplerType::Sobol: return std::unique_ptr<Sampler>(new SobolSampler(seed));
+		case SamplerType::BlueNoise: return std::unique_ptr<Sampler>(new BlueNoiseSampler(seed));
+		default: return std::unique_ptr<Sampler>(new RandomSampler(seed));
+	}
+}
+
+// Shirley and Chiu's concentric mapping, which keeps areas and doesn't distort much.
+vec3 rae::sampleUnitDisk(const vec2& u)
+{
+	const vec2 offset = 2.0f * u - vec2(1.0f, 1.0f);
+	if (offset.x == 0.0f && offset.y == 0.0f)
+		return vec3(0.0f, 0.0f, 0.0f);
+
+	float radius;
+	float theta;
+	if (std::abs(offset.x) > std::abs(offset.y))
+	{
+		radius = offset.x;
+		theta = 0.25f * Math::PI * (offset.y / offset.x);
+	}
+	else
+	{
+		radius = offset.y;
+		theta = 0.5f * Math::PI - 0.25f * Math::PI * (offset.x / offset.y);
+	}
+	return vec3(radius * std::cos(theta), radius * std::sin(theta), 0.0f);
+}
+
+vec3 rae::sampleUnitSphereSurface(const vec2& u)
+{
+	const float z = 1.0f - 2.0f * u.x;
+	const float radius = std::sqrt(std::max(0.0f, 1.0f - z * z));
+	const float phi = Math::TAU * u.y;
+	return vec3(radius * std::cos(phi), radius * std::sin(phi), z);
+}
+
+vec3 rae::sampleUnitBall(const vec2& u, float v)
+{
+	return sampleUnitSphereSurface(u) * std::cbrt(v);
+}
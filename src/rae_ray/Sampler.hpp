@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+enum class SamplerType
+{
+	Random,
+	Halton,
+	Sobol,
+	BlueNoise,
+	Count
+};
+
+String toString(SamplerType type);
+
+// Gives the numbers for one camera sample at a time: first the pixel jitter, then the lens,
+// then the bounces, each taking the next dimension(s). With a low discrepancy sampler the
+// samples of a pixel fill those dimensions more evenly than random numbers do, so the
+// image converges with fewer samples.
+class Sampler
+{
+public:
+	Sampler(uint64_t seed = 0) : m_seed(seed) {}
+	virtual ~Sampler() {}
+
+	virtual SamplerType type() const = 0;
+
+	// Starts a sample of a pixel, from the first dimension. Also seeds threadRandom(), which
+	// the samplers fall back to past the dimensions they support.
+	virtual void startPixelSample(int x, int y, int sampleIndex);
+
+	// In [0, 1).
+	virtual float get1D() = 0;
+	virtual vec2 get2D();
+
+	uint64_t seed() const { return m_seed; }
+
+protected:
+	uint64_t m_seed;
+	int m_x = 0;
+	int m_y = 0;
+	int m_sampleIndex = 0;
+	int m_dimension = 0;
+};
+
+// Independent uniform random numbers, like the tracer has always used.
+class RandomSampler : public Sampler
+{
+public:
+	using Sampler::Sampler;
+
+	SamplerType type() const override { return SamplerType::Random; }
+	float get1D() override;
+};
+
+// Halton sequence with a prime base per dimension, shifted by a random offset per pixel and
+// dimension (Cranley-Patterson rotation), so that neighbouring pixels don't correlate.
+class HaltonSampler : public Sampler
+{
+public:
+	static const int MaxDimensions = 32;
+
+	using Sampler::Sampler;
+
+	SamplerType type() const override { return SamplerType::Halton; }
+	float get1D() override;
+};
+
+// Owen scrambled 2D Sobol points, with the sample order shuffled separately for every
+// dimension pair, as in Burley 2020, "Practical Hash-based Owen Scrambling". Needs only the
+// first two Sobol dimensions, but is good for any number of pairs.
+class SobolSampler : public Sampler
+{
+public:
+	using Sampler::Sampler;
+
+	SamplerType type() const override { return SamplerType::Sobol; }
+	float get1D() override;
+	vec2 get2D() override;
+
+protected:
+	vec2 getPair(bool secondValue);
+
+	bool m_isScrambledPerPixel = true;
+};
+
+// The same scrambled Sobol points in every pixel, shifted per pixel and dimension by a tiled
+// blue noise mask (Georgiev and Fajardo 2016, "Blue-noise Dithered Sampling"). Converges
+// like Sobol, but the error between neighbouring pixels is high frequency noise, which looks
+// a lot smoother at low sample counts.
+class BlueNoiseSampler : public SobolSampler
+{
+public:
+	static const int TileSize = 64;
+
+	BlueNoiseSampler(uint64_t seed = 0) :
+		SobolSampler(seed)
+	{
+		m_isScrambledPerPixel = false;
+	}
+
+	SamplerType type() const override { return SamplerType::BlueNoise; }
+	float get1D() override;
+	vec2 get2D() override;
+
+	// The ranks of the pixels of the tile, 0 to TileSize * TileSize - 1. Generated on first use.
+	static const Array<uint16_t>& tile();
+
+protected:
+	// The mask value of the current pixel for a dimension, in [0, 1).
+	double blueNoise(int dimension) const;
+};
+
+std::unique_ptr<Sampler> createSampler(SamplerType type, uint64_t seed = 0);
+
+// Direct mappings from uniform numbers in [0, 1) to shapes. Unlike rejection sampling, these
+// keep the stratification of low discrepancy samples.
+vec3 sampleUnitDisk(const vec2& u); // z is zero
+vec3 sampleUnitSphereSurface(const vec2& u);
+vec3 sampleUnitBall(const vec2& u, float v);
+
+}
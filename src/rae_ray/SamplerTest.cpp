@@ -0,0 +1,132 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cmath>
+
+#include "rae/visual/Camera.hpp"
+#include "rae_ray/AccumulationBuffer.hpp"
+#include "rae_ray/Bvh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/PathTracer.hpp"
+#include "rae_ray/ReferenceRender.hpp"
+#include "rae_ray/Sampler.hpp"
+#include "rae_ray/Scenes.hpp"
+
+using namespace rae;
+
+// True if each of the count equal sized intervals of [0, 1) has exactly one of the values.
+static bool isStratified(const Array<float>& values, int count)
+{
+	Array<int> hits(count, 0);
+	for (float value : values)
+	{
+		hits[std::min(int(value * count), count - 1)]++;
+	}
+	for (int hitCount : hits)
+	{
+		if (hitCount != 1)
+			return false;
+	}
+	return true;
+}
+
+SCENARIO("Sampler unittest", "[rae][Sampler]")
+{
+	GIVEN( "all the sampler types" )
+	{
+		THEN( "the numbers are in [0, 1) and the same for the same pixel and sample" )
+		{
+			for (int type = 0; type < int(SamplerType::Count); ++type)
+			{
+				// The random sampler uses threadRandom(), so don't interleave two samplers.
+				auto generate = [type]()
+				{
+					std::unique_ptr<Sampler> sampler = createSampler(SamplerType(type), 7);
+					Array<float> values;
+					for (int sample = 0; sample < 300; ++sample)
+					{
+						sampler->startPixelSample(13, 5, sample);
+						for (int dimension = 0; dimension < 50; ++dimension)
+						{
+							values.push_back(sampler->get1D());
+						}
+					}
+					return values;
+				};
+
+				Array<float> values = generate();
+				bool inRange = true;
+				for (float value : values)
+				{
+					if (value < 0.0f || value >= 1.0f)
+						inRange = false;
+				}
+				REQUIRE(createSampler(SamplerType(type))->type() == SamplerType(type));
+				REQUIRE(inRange == true);
+				REQUIRE((values == generate()));
+			}
+		}
+
+		THEN( "the Sobol samples of a pixel are stratified in every dimension pair" )
+		{
+			SobolSampler sampler(3);
+			const int sampleCount = 64;
+			for (int pair = 0; pair < 10; ++pair)
+			{
+				Array<float> first;
+				Array<float> second;
+				for (int sample = 0; sample < sampleCount; ++sample)
+				{
+					sampler.startPixelSample(4, 9, sample);
+					for (int skip = 0; skip < pair; ++skip)
+					{
+						sampler.get2D();
+					}
+					vec2 value = sampler.get2D();
+					first.push_back(value.x);
+					second.push_back(value.y);
+				}
+				REQUIRE(isStratified(first, sampleCount) == true);
+				REQUIRE(isStratified(second, sampleCount) == true);
+			}
+		}
+
+		THEN( "the blue noise tile has every rank once" )
+		{
+			const int count = BlueNoiseSampler::TileSize * BlueNoiseSampler::TileSize;
+			Array<int> ranks(count, 0);
+			for (uint16_t rank : BlueNoiseSampler::tile())
+			{
+				ranks[rank]++;
+			}
+			REQUIRE(std::count(ranks.begin(), ranks.end(), 1) == count);
+		}
+	}
+
+	GIVEN( "the direct mappings" )
+	{
+		THEN( "the points land on their shapes" )
+		{
+			RandomSampler sampler(1);
+			sampler.startPixelSample(0, 0, 0);
+			bool onShapes = true;
+			for (int i = 0; i < 1000; ++i)
+			{
+				vec3 disk = sampleUnitDisk(sampler.get2D());
+				vec3 sphere = sampleUnitSphereSurface(sampler.get2D());
+				vec3 ball = sampleUnitBall(sampler.get2D(), sampler.get1D());
+				if (glm::length(disk) > 1.0001f || disk.z != 0.0f
+					|| std::abs(glm::length(sphere) - 1.0f) > 0.0001f
+					|| glm::length(ball) > 1.0001f)
+				{
+					onShapes = false;
+				}
+			}
+			REQUIRE(onShapes == true);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "rae/core/Types.hpp"
+#include "rae/core/Utils.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Sampler.hpp"
+
+namespace rae
+{
+
+// How each type of material scatters light, as plain functions of the material parameters.
+// Shared by the Material classes and the MaterialTable, so that both shade exactly the same.
+
+inline vec3 reflect(const vec3& v, const vec3& normal)
+{
+	return v - 2.0f * glm::dot(v, normal) * normal;
+}
+
+inline bool refract(const vec3& v, const vec3& n, float ni_over_nt, vec3& refracted)
+{
+	vec3 uv = glm::normalize(v);
+	float dt = glm::dot(uv, n);
+	float discriminant = 1.0f - ni_over_nt * ni_over_nt * (1.0f - dt * dt);
+	if (discriminant > 0)
+	{
+		refracted = ni_over_nt * (uv - n * dt) - n * std::sqrt(discriminant);
+		return true;
+	}
+	return false;
+}
+
+inline float schlick(float cosine, float refractive_index)
+{
+	float r0 = (1.0f - refractive_index) / (1.0f + refractive_index);
+	r0 = r0 * r0;
+	return r0 + (1.0f - r0) * std::pow((1.0f - cosine), 5.0f);
+}
+
+inline bool scatterLambertian(const Color3& albedo, const HitRecord& record, Sampler& sampler,
+	vec3& attenuation, Ray& scattered)
+{
+	// A point on the unit sphere around the normal gives a cosine weighted direction, which is
+	// what lambertianPdf says, and what the light sampling weighs the bounces against.
+	vec3 target = record.point + record.normal + sampleUnitSphereSurface(sampler.get2D());
+	scattered = Ray(record.point, target - record.point);
+	attenuation = albedo;
+	return true;
+}
+
+inline float lambertianPdf(const HitRecord& record, const vec3& direction)
+{
+	return std::max(0.0f, glm::dot(record.normal, direction)) / Math::PI;
+}
+
+inline vec3 evaluateLambertian(const Color3& albedo, const HitRecord& record, const vec3& direction)
+{
+	return albedo * lambertianPdf(record, direction);
+}
+
+inline bool scatterMetal(const Color3& albedo, float roughness, const Ray& r_in, const HitRecord& record,
+	Sampler& sampler, vec3& attenuation, Ray& scattered)
+{
+	vec3 reflected = reflect( glm::normalize(r_in.direction()), record.normal );
+	vec2 direction = sampler.get2D();
+	scattered = Ray(record.point, reflected + roughness * sampleUnitBall(direction, sampler.get1D()));
+	attenuation = albedo;
+	return (glm::dot(scattered.direction(), record.normal) > 0);
+}
+
+inline bool scatterDielectric(float refractiveIndex, const Ray& r_in, const HitRecord& record,
+	Sampler& sampler, vec3& attenuation, Ray& scattered)
+{
+	vec3 outward_normal;
+	vec3 reflected = reflect(r_in.direction(), record.normal);
+	float ni_over_nt;
+	attenuation = vec3(1,1,1);
+	vec3 refracted;
+	float reflect_probability;
+	float cosine;
+	if (glm::dot(r_in.direction(), record.normal) > 0)
+	{
+		outward_normal = -record.normal;
+		ni_over_nt = refractiveIndex;
+		cosine = refractiveIndex * glm::dot(r_in.direction(), record.normal) / r_in.direction().length();
+	}
+	else
+	{
+		outward_normal = record.normal;
+		ni_over_nt = 1.0f / refractiveIndex;
+		cosine = -glm::dot(r_in.direction(), record.normal) / r_in.direction().length();
+	}
+
+	if (refract(r_in.direction(), outward_normal, ni_over_nt, refracted))
+	{
+		reflect_probability = schlick(cosine, refractiveIndex);
+	}
+	else
+	{
+		reflect_probability = 1.0f;
+	}
+
+	if (sampler.get1D() < reflect_probability)
+	{
+		scattered = Ray(record.point, reflected); // REFLECT vs
+	}
+	else
+	{
+		scattered = Ray(record.point, refracted); // REFRACT !!
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,70 @@
+#include "rae_ray/SceneArena.hpp"
+
+#include <algorithm>
+
+using namespace rae;
+
+const size_t SceneArena::DefaultBlockSize;
+
+SceneArena::SceneArena(size_t blockSize) :
+	m_blockSize(blockSize)
+{
+}
+
+SceneArena::~SceneArena()
+{
+	clear();
+}
+
+void* SceneArena::allocate(size_t size, size_t alignment)
+{
+	while (true)
+	{
+		if (m_blockIndex == (int)m_blocks.size())
+		{
+			// Big objects get a block of their own size.
+			Block block;
+			block.size = std::max(m_blockSize, size + alignment);
+			block.memory.reset(new uint8_t[block.size]);
+			m_blocks.push_back(std::move(block));
+		}
+
+		Block& block = m_blocks[m_blockIndex];
+		const uintptr_t address = reinterpret_cast<uintptr_t>(block.memory.get()) + m_blockOffset;
+		const size_t padding = (alignment - address % alignment) % alignment;
+		if (m_blockOffset + padding + size <= block.size)
+		{
+			m_blockOffset += padding + size;
+			m_bytesUsed += size;
+			return reinterpret_cast<void*>(address + padding);
+		}
+
+		// The rest of this block is left unused until the next clear.
+		m_blockIndex++;
+		m_blockOffset = 0;
+	}
+}
+
+void SceneArena::clear()
+{
+	for (auto it = m_destructors.rbegin(); it != m_destructors.rend(); ++it)
+	{
+		it->destroy(it->object);
+	}
+	m_destructors.clear();
+
+	m_blockIndex = 0;
+	m_blockOffset = 0;
+	m_objectCount = 0;
+	m_bytesUsed = 0;
+}
+
+size_t SceneArena::bytesReserved() const
+{
+	size_t bytes = 0;
+	for (const Block& block : m_blocks)
+	{
+		bytes += block.size;
+	}
+	return bytes;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "rae/core/Types.hpp"
+
+namespace rae
+{
+
+// Owns the objects of a tracer scene, like the hitables and the materials they share, in big
+// blocks of memory instead of one heap allocation each. clear() destroys them all at once and
+// keeps the blocks for the next scene, so switching scenes doesn't go back to the heap unless
+// the new scene is bigger than any before it. Not thread safe: fill it from one thread while
+// nothing traces the scene.
+class SceneArena
+{
+public:
+	static const size_t DefaultBlockSize = 256 * 1024;
+
+	explicit SceneArena(size_t blockSize = DefaultBlockSize);
+	~SceneArena();
+
+	SceneArena(const SceneArena&) = delete;
+	void operator=(const SceneArena&) = delete;
+
+	// The object lives until clear(). Its destructor is called then, if it has one to call.
+	template <typename T, typename... Args>
+	T* create(Args&&... args);
+	void* allocate(size_t size, size_t alignment);
+	// Destroys the objects in the reverse order they were created in.
+	void clear();
+
+	int objectCount() const { return m_objectCount; }
+	size_t bytesUsed() const { return m_bytesUsed; }
+	// Of all the blocks, used or not.
+	size_t bytesReserved() const;
+	int blockCount() const { return (int)m_blocks.size(); }
+
+protected:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> memory;
+		size_t size = 0;
+	};
+
+	struct Destructor
+	{
+		void* object;
+		void (*destroy)(void* object);
+	};
+
+	template <typename T>
+	static void destroy(void* object)
+	{
+		static_cast<T*>(object)->~T();
+	}
+
+	size_t m_blockSize;
+	Array<Block> m_blocks;
+	int m_blockIndex = 0; // The block being filled.
+	size_t m_blockOffset = 0;
+
+	Array<Destructor> m_destructors;
+	int m_objectCount = 0;
+	size_t m_bytesUsed = 0;
+};
+
+template <typename T, typename... Args>
+T* SceneArena::create(Args&&... args)
+{
+	T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	if (std::is_trivially_destructible<T>::value == false)
+		m_destructors.push_back({ object, &SceneArena::destroy<T> });
+	m_objectCount++;
+	return object;
+}
+
+}
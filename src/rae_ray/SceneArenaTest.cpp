@@ -0,0 +1,100 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Camera.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/SceneArena.hpp"
+#include "rae_ray/Scenes.hpp"
+#include "rae_ray/Sphere.hpp"
+
+using namespace rae;
+
+namespace
+{
+	struct Counted
+	{
+		Counted(int& count) : m_count(count) { m_count++; }
+		~Counted() { m_count--; }
+		int& m_count;
+	};
+
+	struct alignas(32) Aligned
+	{
+		float values[8];
+	};
+}
+
+SCENARIO("SceneArena unittest", "[rae][SceneArena]")
+{
+	GIVEN( "an arena with small blocks" )
+	{
+		SceneArena arena(/*blockSize*/1024);
+
+		THEN( "objects are aligned, destroyed on clear, and the blocks are reused" )
+		{
+			int liveCount = 0;
+			for (int i = 0; i < 100; ++i)
+			{
+				arena.create<Counted>(liveCount);
+				Aligned* aligned = arena.create<Aligned>();
+				REQUIRE((reinterpret_cast<uintptr_t>(aligned) % 32) == 0);
+			}
+			REQUIRE(liveCount == 100);
+			REQUIRE(arena.objectCount() == 200);
+			REQUIRE(arena.blockCount() > 1);
+
+			const size_t reserved = arena.bytesReserved();
+			arena.clear();
+			REQUIRE(liveCount == 0);
+			REQUIRE(arena.objectCount() == 0);
+			REQUIRE(arena.bytesUsed() == 0);
+
+			for (int i = 0; i < 100; ++i)
+			{
+				arena.create<Counted>(liveCount);
+				arena.create<Aligned>();
+			}
+			REQUIRE(arena.bytesReserved() == reserved);
+		}
+
+		THEN( "a bigger object than a block gets a block of its own" )
+		{
+			struct Big
+			{
+				char data[4000];
+			};
+			Big* big = arena.create<Big>();
+			big->data[3999] = 1;
+			REQUIRE(arena.bytesReserved() >= sizeof(Big));
+		}
+	}
+
+	GIVEN( "a world that switches between the scenes" )
+	{
+		HitableList world;
+		Camera camera;
+
+		THEN( "the scenes are in the arena and the memory stays the same after the first round" )
+		{
+			createSceneOne(world, camera);
+			createSceneFromBook(world, camera); // Both at once, the biggest the arena needs to be.
+			REQUIRE(world.arena().objectCount() > 400);
+			const size_t reserved = world.arena().bytesReserved();
+
+			for (int round = 0; round < 100; ++round)
+			{
+				world.clear();
+				REQUIRE(world.list().empty());
+				if (round % 2 == 0)
+					createSceneOne(world, camera);
+				else createSceneFromBook(world, camera);
+			}
+			REQUIRE(world.arena().bytesReserved() == reserved);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "rae_ray/Scenes.hpp"
+
+#include <memory>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "rae/core/Utils.hpp"
+#include "rae/core/Random.hpp"
+
+#include "rae/visual/Camera.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/Instance.hpp"
+#include "rae_ray/Sphere.hpp"
+#include "rae_ray/SphereSet.hpp"
+
+using namespace rae;
+
+void rae::createSceneOne(HitableList& world, Camera& camera, bool loadBunny)
+{
+	camera.setFieldOfViewDeg(44.6f);
+
+	//camera.setPosition(vec3(0.698890f, 1.275992f, 6.693169f));
+	//camera.setYaw(Math::toRadians(188.0f));
+	//camera.setPitch(Math::toRadians(-7.744f));
+	//camera.setAperture(0.3f);
+	//camera.setFocusDistance(7.6f);
+
+	camera.setPosition(vec3(-0.16f, 2.9664f, 14.8691f));
+	camera.setYaw(Math::toRadians(178.560333f));
+	camera.setPitch(Math::toRadians(-10.8084f));
+	camera.setAperture(0.07f);
+	camera.setFocusDistance(14.763986f);
+
+	// A big light
+	world.create<Sphere>(vec3(0.0f, 6.0f, -1.0f), 2.0f,
+		world.createMaterial<Light>(vec3(4.0f, 4.0f, 4.0f)));
+
+	// A small light
+	world.create<Sphere>(vec3(3.85, 2.3, -0.15f), 0.2f,
+		world.createMaterial<Light>(vec3(16.0f, 16.0f, 16.0f)));
+
+	// A ball
+	world.create<Sphere>(vec3(0, 0.3, -2), 0.5f,
+		world.createMaterial<Lambertian>(vec3(0.8f, 0.3f, 0.3f)));
+	// The planet
+	world.create<Sphere>(vec3(0, -100.5f, -1), 100.0f,
+		world.createMaterial<Lambertian>(vec3(0.0f, 0.7f, 0.8f)));
+	
+	// Metal balls
+	world.create<Sphere>(vec3(1, 0, 0), 0.5f,
+		world.createMaterial<Metal>(vec3(0.8f, 0.6f, 0.2f), /*roughness*/0.0f));
+	world.create<Sphere>(vec3(-1.5f, 0.65f, 0.5), 0.4f,
+		world.createMaterial<Metal>(vec3(0.8f, 0.4f, 0.8f), /*roughness*/0.3f));
+	// Dielectric, glass ball
+	world.create<Sphere>(vec3(-1, 0, 1), 0.5f,
+		world.createMaterial<Dielectric>(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f));
+	world.create<Sphere>(vec3(-3.15f, 0.1f, -5), 0.6f,
+		world.createMaterial<Lambertian>(vec3(0.05f, 0.2f, 0.8f)));
+
+	///////////////////
+
+	auto bunny = world.create<Mesh>();
+	if (loadBunny)
+		bunny->loadModel("./data/models/bunny.obj");
+	else bunny->generateBox();
+}
+
+void rae::createSceneFromBook(HitableList& list, Camera& camera)
+{
+	camera.setPosition(vec3(16.857f, 2.0f, 6.474f));
+	camera.setYaw(Math::toRadians(247.8f));
+	camera.setPitch(Math::toRadians(-4.762f));
+	camera.setAperture(0.1f);
+	camera.setFocusDistance(17.29f);
+
+	// All the spheres in one SphereSet, which intersects them in SIMD batches.
+	auto spheres = list.create<SphereSet>();
+
+	spheres->add(vec3(0,-1000,0), 1000, list.createMaterial<Lambertian>(vec3(0.5, 0.5, 0.5)));
+
+	for (int a = -11; a < 11; a++)
+	{
+		for (int b = -11; b < 11; b++)
+		{
+			float choose_mat = getRandom();
+			vec3 center(a + 0.9f * getRandom(), 0.2f, b + 0.9f * getRandom());
+			if ((center-vec3(4,0.2,0)).length() > 0.9f)
+			{ 
+				if (choose_mat < 0.8f)
+				{
+					// diffuse
+					spheres->add(center, 0.2f, list.createMaterial<Lambertian>(vec3( getRandom()*getRandom(), getRandom()*getRandom(), getRandom()*getRandom())));
+				}
+				else if (choose_mat < 0.95f)
+				{
+					// metal
+					spheres->add(center, 0.2f,
+							list.createMaterial<Metal>(vec3(0.5f*(1.0f + getRandom()), 0.5f*(1.0f + getRandom()), 0.5f*(1.0f + getRandom())), /*roughness*/ 0.5f*getRandom()));
+				}
+				else
+				{
+					// glass
+					spheres->add(center, 0.2f, list.createMaterial<Dielectric>(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f));
+				}
+			}
+		}
+	}
+
+	spheres->add(vec3(0, 1, 0), 1.0, list.createMaterial<Dielectric>(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f));
+	spheres->add(vec3(-4, 1, 0), 1.0, list.createMaterial<Lambertian>(vec3(0.0, 0.2, 0.9)));
+	spheres->add(vec3(4, 1, 0), 1.0, list.createMaterial<Metal>(vec3(0.7, 0.6, 0.5), 0.0));
+
+	spheres->build();
+}
+
+void rae::createSceneInstances(HitableList& world, Camera& camera, bool loadBunny, int gridSize)
+{
+	camera.setFieldOfViewDeg(44.6f);
+	camera.setPosition(vec3(0.0f, 7.0f, 26.0f));
+	camera.setYaw(Math::toRadians(180.0f));
+	camera.setPitch(Math::toRadians(-16.0f));
+	camera.setAperture(0.0f);
+	camera.setFocusDistance(26.0f);
+
+	world.create<Sphere>(vec3(0.0f, 30.0f, 10.0f), 10.0f,
+		world.createMaterial<Light>(vec3(3.0f, 3.0f, 3.0f)));
+	world.create<Sphere>(vec3(0, -1000.5f, 0), 1000.0f,
+		world.createMaterial<Lambertian>(vec3(0.5f, 0.5f, 0.5f)));
+
+	auto mesh = std::make_shared<Mesh>();
+	if (loadBunny == false || mesh->loadModel("./data/models/bunny.obj") == false)
+		mesh->generateBox();
+	// Stand them on the ground.
+	const float bottom = mesh->getAabb().min().y;
+
+	// A few materials shared by all the instances.
+	std::shared_ptr<Material> materials[] =
+	{
+		std::make_shared<Lambertian>(vec3(0.8f, 0.3f, 0.3f)),
+		std::make_shared<Lambertian>(vec3(0.2f, 0.6f, 0.3f)),
+		std::make_shared<Metal>(vec3(0.8f, 0.6f, 0.2f), /*roughness*/0.2f),
+		std::make_shared<Dielectric>(vec3(0.8f, 0.5f, 0.3f), /*refractive_index*/1.5f)
+	};
+
+	const float spacing = 1.2f;
+	for (int a = -gridSize / 2; a < gridSize - gridSize / 2; ++a)
+	{
+		for (int b = -gridSize / 2; b < gridSize - gridSize / 2; ++b)
+		{
+			const float scale = getRandom(0.5f, 1.0f);
+			const vec3 position(spacing * a, -0.5f - bottom * scale, spacing * b);
+			const mat4 transform = glm::scale(
+				glm::rotate(glm::translate(mat4(1.0f), position), getRandom(0.0f, Math::TAU), vec3(0.0f, 1.0f, 0.0f)),
+				vec3(scale));
+			world.create<Instance>(mesh, transform, materials[getRandomInt(0, 3)]);
+		}
+	}
+}
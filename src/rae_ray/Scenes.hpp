@@ -0,0 +1,16 @@
+#pragma once
+
+namespace rae
+{
+
+class HitableList;
+class Camera;
+
+// Test scenes for the ray tracer. They add their objects to the world and set up the camera,
+// but don't build the Bvh.
+void createSceneOne(HitableList& world, Camera& camera, bool loadBunny = false);
+void createSceneFromBook(HitableList& world, Camera& camera);
+// A field of instances of one bunny, or of one box without the bunny, sharing one mesh and its tree.
+void createSceneInstances(HitableList& world, Camera& camera, bool loadBunny = false, int gridSize = 32);
+
+}
@@ -3,16 +3,14 @@
 #include "HitRecord.hpp"
 #include "rae/visual/Box.hpp"
 #include "rae/visual/Material.hpp"
+#include "rae_ray/MaterialTable.hpp"
+#include "rae_ray/RayStats.hpp"
 
 using namespace rae;
 
-Sphere::~Sphere()
-{
-	delete material; // Hmm. Currently no shared materials... TODO memory management.
-}
-
 bool Sphere::hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const
 {
+	RAE_COUNT_RAY_STAT(sphereTestCount, 1);
 	vec3 oc = ray.origin() - center;
 	float a = glm::dot(ray.direction(), ray.direction());
 	float b = glm::dot(oc, ray.direction());
@@ -27,6 +25,7 @@ bool Sphere::hit(const Ray& ray, float t_min, float t_max, HitRecord& record) co
 			record.point = ray.pointAtParameter(record.t);
 			record.normal = (record.point - center) / radius;
 			record.material = material;
+			record.materialIndex = materialIndex;
 			return true;
 		}
 	}
@@ -38,3 +37,8 @@ Box Sphere::getAabb(float t0, float t1) const
 	vec3 cornerVec = vec3(radius, radius, radius);
 	return Box(center - cornerVec, center + cornerVec);
 }
+
+void Sphere::bindMaterials(MaterialTable& table)
+{
+	materialIndex = material ? table.add(*material) : -1;
+}
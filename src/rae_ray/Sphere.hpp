@@ -24,14 +24,14 @@ public:
 		material(setMaterial)
 	{}
 
-	~Sphere();
-
 	virtual bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const;
 	virtual Box getAabb(float t0, float t1) const;
+	void bindMaterials(MaterialTable& table) override;
 
 	vec3 center;
 	float radius;
-	Material* material;
+	Material* material; // Not owned. Shared with other hitables, like the ones in a SceneArena.
+	int materialIndex = -1;
 };
 
 }
@@ -0,0 +1,238 @@
+#include "rae_ray/SphereSet.hpp"
+
+#include <cmath>
+
+#include "rae/visual/Ray.hpp"
+#include "rae/visual/Material.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/MaterialTable.hpp"
+
+using namespace rae;
+
+const int SphereSet::BatchSize;
+
+SphereSet::~SphereSet()
+{
+	clear();
+}
+
+void SphereSet::clear()
+{
+	m_materials.clear();
+	m_materialIndices.clear();
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_radius.clear();
+	m_tree.clear();
+}
+
+void SphereSet::add(const vec3& center, float radius, Material* material)
+{
+	if (m_tree.isEmpty() == false)
+	{
+		// Adding after build: drop the padding, and the tree is no longer valid.
+		m_centerX.resize(size());
+		m_centerY.resize(size());
+		m_centerZ.resize(size());
+		m_radius.resize(size());
+		m_tree.clear();
+	}
+
+	m_centerX.push_back(center.x);
+	m_centerY.push_back(center.y);
+	m_centerZ.push_back(center.z);
+	m_radius.push_back(radius);
+	m_materials.push_back(material);
+	m_materialIndices.push_back(-1);
+}
+
+void SphereSet::build()
+{
+	const int count = size();
+	if (m_tree.isEmpty() == false || count == 0)
+		return;
+
+	Array<Box> aabbs;
+	aabbs.reserve(count);
+	for (int i = 0; i < count; ++i)
+	{
+		const vec3 center(m_centerX[i], m_centerY[i], m_centerZ[i]);
+		const vec3 cornerVec(m_radius[i], m_radius[i], m_radius[i]);
+		aabbs.push_back(Box(center - cornerVec, center + cornerVec));
+	}
+
+	BvhBuildOptions options;
+	// Leaves of up to two SIMD batches.
+	options.maxPrimitivesInLeaf = 2 * BatchSize;
+	options.primitiveBatchSize = BatchSize;
+	m_tree.build(aabbs, options);
+
+	// Put the spheres in the order the leaves refer to them, and pad the end.
+	const Array<int>& order = m_tree.primitiveIndices();
+	auto reorder = [&order](Array<float>& values)
+	{
+		Array<float> ordered;
+		ordered.reserve(order.size() + BatchSize - 1);
+		for (int index : order)
+		{
+			ordered.push_back(values[index]);
+		}
+		ordered.resize(order.size() + BatchSize - 1, 0.0f);
+		values.swap(ordered);
+	};
+	reorder(m_centerX);
+	reorder(m_centerY);
+	reorder(m_centerZ);
+	reorder(m_radius);
+
+	Array<Material*> orderedMaterials;
+	Array<int> orderedMaterialIndices;
+	orderedMaterials.reserve(order.size());
+	orderedMaterialIndices.reserve(order.size());
+	for (int index : order)
+	{
+		orderedMaterials.push_back(m_materials[index]);
+		orderedMaterialIndices.push_back(m_materialIndices[index]);
+	}
+	m_materials.swap(orderedMaterials);
+	m_materialIndices.swap(orderedMaterialIndices);
+}
+
+void SphereSet::bindMaterials(MaterialTable& table)
+{
+	for (int i = 0; i < size(); ++i)
+	{
+		m_materialIndices[i] = m_materials[i] ? table.add(*m_materials[i]) : -1;
+	}
+}
+
+bool SphereSet::hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const
+{
+	float closestDistance = t_max;
+	int hitSphere = -1;
+
+	m_tree.traverseLeaves(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
+	{
+		RAE_COUNT_RAY_STAT(sphereTestCount, end - begin);
+		// Shrinks farT to keep the closest hit.
+		int sphere = intersect(ray, begin, end, nearT, farT);
+		if (sphere == -1)
+			return false;
+
+		closestDistance = farT;
+		hitSphere = sphere;
+		return true;
+	});
+
+	if (hitSphere == -1)
+		return false;
+
+	const vec3 center(m_centerX[hitSphere], m_centerY[hitSphere], m_centerZ[hitSphere]);
+	record.t = closestDistance;
+	record.point = ray.pointAtParameter(record.t);
+	record.normal = (record.point - center) / m_radius[hitSphere];
+	record.material = m_materials[hitSphere];
+	record.materialIndex = m_materialIndices[hitSphere];
+	return true;
+}
+
+bool SphereSet::occluded(const Ray& ray, float t_min, float t_max) const
+{
+	return m_tree.traverseLeavesAny(ray, t_min, t_max, [&](int begin, int end, float nearT, float& farT)
+	{
+		RAE_COUNT_RAY_STAT(sphereTestCount, end - begin);
+		return intersect(ray, begin, end, nearT, farT) != -1;
+	});
+}
+
+Box SphereSet::getAabb(float /*t0*/, float /*t1*/) const
+{
+	return m_tree.getAabb();
+}
+
+int SphereSet::intersectScalar(const Ray& ray, int begin, int end, float t_min, float& t_max) const
+{
+	const vec3 origin = ray.origin();
+	const vec3 direction = ray.direction();
+	const float a = glm::dot(direction, direction);
+	int hitIndex = -1;
+
+	for (int i = begin; i < end; ++i)
+	{
+		const vec3 oc = origin - vec3(m_centerX[i], m_centerY[i], m_centerZ[i]);
+		const float b = glm::dot(oc, direction);
+		const float c = glm::dot(oc, oc) - m_radius[i] * m_radius[i];
+		const float discriminant = b * b - a * c;
+		if (discriminant > 0.0f)
+		{
+			const float t = (-b - std::sqrt(discriminant)) / a;
+			if (t < t_max && t > t_min)
+			{
+				t_max = t;
+				hitIndex = i;
+			}
+		}
+	}
+	return hitIndex;
+}
+
+#ifdef RAE_SIMD_SCALAR
+
+int SphereSet::intersect(const Ray& ray, int begin, int end, float t_min, float& t_max) const
+{
+	return intersectScalar(ray, begin, end, t_min, t_max);
+}
+
+#else
+
+int SphereSet::intersect(const Ray& ray, int begin, int end, float t_min, float& t_max) const
+{
+	const vec3 rayOrigin = ray.origin();
+	const vec3 rayDirection = ray.direction();
+	const SimdFloat originX(rayOrigin.x), originY(rayOrigin.y), originZ(rayOrigin.z);
+	const SimdFloat directionX(rayDirection.x), directionY(rayDirection.y), directionZ(rayDirection.z);
+	const SimdFloat a(glm::dot(rayDirection, rayDirection));
+	const SimdFloat zero(0.0f);
+
+	int hitIndex = -1;
+	alignas(32) float distances[BatchSize];
+
+	for (int i = begin; i < end; i += BatchSize)
+	{
+		// The same operations in the same order as intersectScalar, so the results match exactly.
+		const SimdFloat ocX = originX - SimdFloat::load(&m_centerX[i]);
+		const SimdFloat ocY = originY - SimdFloat::load(&m_centerY[i]);
+		const SimdFloat ocZ = originZ - SimdFloat::load(&m_centerZ[i]);
+		const SimdFloat radius = SimdFloat::load(&m_radius[i]);
+
+		const SimdFloat b = ocX * directionX + ocY * directionY + ocZ * directionZ;
+		const SimdFloat c = (ocX * ocX + ocY * ocY + ocZ * ocZ) - radius * radius;
+		const SimdFloat discriminant = b * b - a * c;
+
+		int mask = moveMask(discriminant > zero);
+		if (end - i < BatchSize)
+			mask &= (1 << (end - i)) - 1; // Lanes past the leaf belong to other leaves.
+		if (mask == 0)
+			continue;
+
+		const SimdFloat t = (zero - b - squareRoot(discriminant)) / a;
+		mask &= moveMask((t > SimdFloat(t_min)) & (t < SimdFloat(t_max)));
+		if (mask == 0)
+			continue;
+
+		// Go through the hits in order, like the scalar loop does, so ties resolve the same way.
+		t.store(distances);
+		for (int lane = 0; lane < BatchSize; ++lane)
+		{
+			if ((mask & (1 << lane)) && distances[lane] < t_max)
+			{
+				t_max = distances[lane];
+				hitIndex = i + lane;
+			}
+		}
+	}
+	return hitIndex;
+}
+
+#endif
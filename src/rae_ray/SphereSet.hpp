@@ -0,0 +1,59 @@
+#pragma once
+
+#include "rae/core/Types.hpp"
+#include "rae/core/Simd.hpp"
+
+#include "rae_ray/Hitable.hpp"
+#include "rae_ray/Bvh.hpp"
+
+namespace rae
+{
+
+class Material;
+
+// Many spheres as one hitable. The centers and radii are stored as structure of arrays in the
+// order of the leaves of its own Bvh, so that a leaf is tested BatchSize spheres at a time
+// with SIMD, instead of one virtual Sphere::hit call per sphere.
+class SphereSet : public Hitable
+{
+public:
+	static const int BatchSize = SimdWidth;
+
+	SphereSet(){}
+	~SphereSet();
+
+	// The material isn't owned, like in Sphere.
+	void add(const vec3& center, float radius, Material* material);
+	// Builds the Bvh and reorders the spheres to match it. Call after adding the spheres.
+	void build();
+	void clear();
+
+	int size() const { return (int)m_materials.size(); }
+
+	bool hit(const Ray& ray, float t_min, float t_max, HitRecord& record) const override;
+	bool occluded(const Ray& ray, float t_min, float t_max) const override;
+	Box getAabb(float t0, float t1) const override;
+	void bindMaterials(MaterialTable& table) override;
+
+	// Closest hit of the spheres [begin, end) between t_min and t_max. Returns the index of the
+	// sphere and sets t_max to the distance, or returns -1. Only the near side of a sphere counts,
+	// like in Sphere::hit.
+	int intersect(const Ray& ray, int begin, int end, float t_min, float& t_max) const;
+	// The same one sphere at a time. Used when there is no SIMD and as a reference for it.
+	int intersectScalar(const Ray& ray, int begin, int end, float t_min, float& t_max) const;
+
+	const BvhTree& tree() const { return m_tree; }
+
+protected:
+	BvhTree m_tree;
+
+	// Padded with BatchSize - 1 zero radius spheres, so that a batch can always be loaded whole.
+	Array<float> m_centerX;
+	Array<float> m_centerY;
+	Array<float> m_centerZ;
+	Array<float> m_radius;
+	Array<Material*> m_materials;
+	Array<int> m_materialIndices; // Into the bound MaterialTable, in the same order.
+};
+
+}
@@ -0,0 +1,104 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cfloat>
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/HitableList.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/Sphere.hpp"
+#include "rae_ray/SphereSet.hpp"
+
+using namespace rae;
+
+// The same spheres as separate Sphere objects and in a SphereSet. Without materials,
+// which the intersection tests don't need.
+static void createSpheres(HitableList& world, SphereSet& spheres, int gridSize)
+{
+	world.add(new Sphere(vec3(0, -1000, 0), 1000, nullptr));
+	spheres.add(vec3(0, -1000, 0), 1000, nullptr);
+
+	for (int a = -gridSize; a < gridSize; a++)
+	{
+		for (int b = -gridSize; b < gridSize; b++)
+		{
+			vec3 center(a + 0.9f * getRandom(), 0.2f, b + 0.9f * getRandom());
+			float radius = getRandom(0.1f, 0.45f);
+			world.add(new Sphere(center, radius, nullptr));
+			spheres.add(center, radius, nullptr);
+		}
+	}
+
+	spheres.build();
+}
+
+static Ray randomRay(float extent)
+{
+	vec3 origin(getRandom(-extent, extent), getRandom(0.1f, 5.0f), getRandom(-extent, extent));
+	vec3 direction(getRandom(-1.0f, 1.0f), getRandom(-1.0f, 0.5f), getRandom(-1.0f, 1.0f));
+	return Ray(origin, direction);
+}
+
+SCENARIO("SphereSet unittest", "[rae][SphereSet]")
+{
+	GIVEN( "a grid of spheres as separate Spheres and as a SphereSet" )
+	{
+		HitableList world;
+		SphereSet spheres;
+		createSpheres(world, spheres, /*gridSize*/11);
+
+		REQUIRE(spheres.size() == (int)world.list().size());
+
+		THEN( "the " + String(SimdName) + " kernel finds the same hits as the scalar one for any range" )
+		{
+			int mismatches = 0;
+			for (int i = 0; i < 2000; ++i)
+			{
+				Ray ray = randomRay(12.0f);
+				int begin = getRandomInt(0, spheres.size() - 1);
+				int end = getRandomInt(begin + 1, spheres.size());
+
+				float simdDistance = FLT_MAX;
+				float scalarDistance = FLT_MAX;
+				int simdHit = spheres.intersect(ray, begin, end, 0.001f, simdDistance);
+				int scalarHit = spheres.intersectScalar(ray, begin, end, 0.001f, scalarDistance);
+
+				if (simdHit != scalarHit || simdDistance != scalarDistance)
+					mismatches++;
+			}
+			REQUIRE(mismatches == 0);
+		}
+
+		THEN( "rays and shadow rays hit the same things as with the separate Spheres" )
+		{
+			int mismatches = 0;
+			int hits = 0;
+			for (int i = 0; i < 2000; ++i)
+			{
+				Ray ray = randomRay(12.0f);
+				HitRecord setRecord;
+				HitRecord listRecord;
+				bool setHit = spheres.hit(ray, 0.001f, FLT_MAX, setRecord);
+				bool listHit = world.hit(ray, 0.001f, FLT_MAX, listRecord);
+
+				// Sphere::hit takes the square root in double, so allow for rounding.
+				if (setHit != listHit
+					|| (setHit && std::abs(setRecord.t - listRecord.t) > 0.0001f * listRecord.t)
+					|| spheres.occluded(ray, 0.001f, FLT_MAX) != listHit
+					|| (listHit && spheres.occluded(ray, 0.001f, 0.99f * listRecord.t)))
+				{
+					mismatches++;
+				}
+				if (setHit)
+					hits++;
+			}
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "rae_ray/TileScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace rae;
+
+const int TileScheduler::DefaultTileSize;
+
+void TileScheduler::init(int width, int height, int tileSize)
+{
+	m_width = width;
+	m_height = height;
+	m_tiles.clear();
+
+	for (int y = 0; y < height; y += tileSize)
+	{
+		for (int x = 0; x < width; x += tileSize)
+		{
+			Tile tile;
+			tile.x = x;
+			tile.y = y;
+			tile.width = std::min(tileSize, width - x);
+			tile.height = std::min(tileSize, height - y);
+			m_tiles.push_back(tile);
+		}
+	}
+
+	m_order.resize(m_tiles.size());
+	m_costs.assign(m_tiles.size(), 0.0);
+	m_hasCosts = false;
+	m_finishedCount = 0;
+}
+
+void TileScheduler::sortTiles(TileOrder order)
+{
+	for (int i = 0; i < tileCount(); ++i)
+	{
+		m_order[i] = i;
+	}
+
+	if (order == TileOrder::CostliestFirst && m_hasCosts)
+	{
+		std::stable_sort(m_order.begin(), m_order.end(), [this](int a, int b)
+		{
+			return m_costs[a] > m_costs[b];
+		});
+		return;
+	}
+
+	// Doubled coordinates, so the distances stay integers and the order doesn't depend on rounding.
+	auto distanceToCenter = [this](int index)
+	{
+		const Tile& tile = m_tiles[index];
+		const long long dx = 2 * tile.x + tile.width - m_width;
+		const long long dy = 2 * tile.y + tile.height - m_height;
+		return dx * dx + dy * dy;
+	};
+	std::stable_sort(m_order.begin(), m_order.end(), [&distanceToCenter](int a, int b)
+	{
+		return distanceToCenter(a) < distanceToCenter(b);
+	});
+}
+
+void TileScheduler::run(TileOrder order, const std::function<void(int)>& renderTile, ThreadPool& pool)
+{
+	sortTiles(order);
+	m_nextTile = 0;
+	m_finishedCount = 0;
+
+	// One task per thread, each taking the next tile in order until there are none left. Tiles
+	// are uneven, so this balances better than splitting them up front.
+	pool.parallelFor(0, pool.concurrency(), /*grainSize*/1, [&](int, int)
+	{
+		for (int next = m_nextTile++; next < tileCount(); next = m_nextTile++)
+		{
+			const int tileIndex = m_order[next];
+			auto start = std::chrono::steady_clock::now();
+			renderTile(tileIndex);
+			m_costs[tileIndex] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			m_finishedCount++;
+		}
+	});
+
+	m_hasCosts = true;
+}
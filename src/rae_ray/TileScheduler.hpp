@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include "rae/core/Types.hpp"
+#include "rae/core/ThreadPool.hpp"
+
+namespace rae
+{
+
+struct Tile
+{
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+enum class TileOrder
+{
+	CenterOut, // Closest to the middle of the image first, where the viewer is most likely looking.
+	CostliestFirst // The slowest tiles of the previous pass first, so no thread is left with a slow tile at the end.
+};
+
+// Splits an image into tiles and hands them out to the threads one at a time, so a thread
+// that finishes early just takes the next tile, and each tile can be shown as soon as it is done.
+class TileScheduler
+{
+public:
+	static const int DefaultTileSize = 32;
+
+	// The tiles at the right and bottom edges are smaller if the size doesn't divide evenly.
+	void init(int width, int height, int tileSize = DefaultTileSize);
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int tileCount() const { return (int)m_tiles.size(); }
+	const Tile& tile(int index) const { return m_tiles[index]; }
+
+	// Calls renderTile(tileIndex) for every tile once, in the given order, on the calling thread
+	// and the workers of the pool. Other threads waiting for the pool at the same time never get
+	// the tiles. Returns when all the tiles are done. CostliestFirst falls back to CenterOut until
+	// a pass has measured the costs.
+	void run(TileOrder order, const std::function<void(int)>& renderTile, ThreadPool& pool = getThreadPool());
+
+	// How many tiles of the current pass are done. Safe to read from other threads.
+	int finishedCount() const { return m_finishedCount; }
+	// The tile indices in the order of the last pass.
+	const Array<int>& order() const { return m_order; }
+	// How long each tile took in the last pass, in seconds.
+	const Array<double>& costs() const { return m_costs; }
+
+protected:
+	void sortTiles(TileOrder order);
+
+	int m_width = 0;
+	int m_height = 0;
+	Array<Tile> m_tiles;
+	Array<int> m_order;
+	Array<double> m_costs;
+	bool m_hasCosts = false;
+
+	std::atomic<int> m_nextTile{0};
+	std::atomic<int> m_finishedCount{0};
+};
+
+}
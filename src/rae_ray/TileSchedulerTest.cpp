@@ -0,0 +1,112 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "rae/core/ThreadPool.hpp"
+#include "rae_ray/TileScheduler.hpp"
+
+using namespace rae;
+
+SCENARIO("TileScheduler unittest", "[rae][TileScheduler]")
+{
+	GIVEN( "an image that doesn't divide evenly into tiles" )
+	{
+		const int width = 100;
+		const int height = 70;
+		TileScheduler scheduler;
+		scheduler.init(width, height, /*tileSize*/32);
+
+		REQUIRE(scheduler.tileCount() == 4 * 3);
+
+		THEN( "a pass on many threads renders every pixel exactly once" )
+		{
+			ThreadPool pool(3);
+			Array<std::atomic<int>> visits(width * height);
+			for (auto&& count : visits)
+			{
+				count = 0;
+			}
+
+			scheduler.run(TileOrder::CenterOut, [&](int tileIndex)
+			{
+				const Tile& tile = scheduler.tile(tileIndex);
+				for (int y = tile.y; y < tile.y + tile.height; ++y)
+				{
+					for (int x = tile.x; x < tile.x + tile.width; ++x)
+					{
+						visits[y * width + x]++;
+					}
+				}
+			}, pool);
+
+			bool allOnes = true;
+			for (auto&& count : visits)
+			{
+				if (count != 1)
+					allOnes = false;
+			}
+			REQUIRE(allOnes == true);
+			REQUIRE(scheduler.finishedCount() == scheduler.tileCount());
+		}
+
+		THEN( "center out starts from the tile in the middle" )
+		{
+			scheduler.run(TileOrder::CenterOut, [](int) {});
+			const Tile& first = scheduler.tile(scheduler.order()[0]);
+			const int endX = first.x + first.width;
+			const int endY = first.y + first.height;
+			REQUIRE(first.x <= width / 2);
+			REQUIRE(endX > width / 2);
+			REQUIRE(first.y <= height / 2);
+			REQUIRE(endY > height / 2);
+		}
+
+		THEN( "costliest first follows the costs of the previous pass" )
+		{
+			const int slowTile = 5;
+			scheduler.run(TileOrder::CostliestFirst, [&](int tileIndex)
+			{
+				if (tileIndex == slowTile)
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			});
+			scheduler.run(TileOrder::CostliestFirst, [](int) {});
+			REQUIRE(scheduler.order()[0] == slowTile);
+		}
+
+		THEN( "another thread waiting for the pool during a pass never renders the tiles" )
+		{
+			// Like the UI thread converting the frame while the render thread runs a pass.
+			ThreadPool pool(1);
+			const std::thread::id waitingThread = std::this_thread::get_id();
+			std::atomic<bool> isPassDone(false);
+			std::atomic<int> tilesOnWaitingThread(0);
+
+			std::thread renderThread([&]()
+			{
+				scheduler.run(TileOrder::CenterOut, [&](int)
+				{
+					if (std::this_thread::get_id() == waitingThread)
+						tilesOnWaitingThread++;
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				}, pool);
+				isPassDone = true;
+			});
+
+			while (isPassDone == false)
+			{
+				pool.parallelFor(0, 64, /*grainSize*/1, [](int, int) {});
+			}
+			renderThread.join();
+
+			REQUIRE(tilesOnWaitingThread == 0);
+			REQUIRE(scheduler.finishedCount() == scheduler.tileCount());
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "rae_ray/TriangleSet.hpp"
+
+#include "rae/visual/Ray.hpp"
+
+using namespace rae;
+
+const int TriangleSet::BatchSize;
+
+static const float TriangleEpsilon = 0.000001f;
+
+void TriangleSet::clear()
+{
+	m_count = 0;
+	for (Array<float>* array : { &m_v0x, &m_v0y, &m_v0z, &m_edge1x, &m_edge1y, &m_edge1z, &m_edge2x, &m_edge2y, &m_edge2z })
+	{
+		array->clear();
+	}
+}
+
+void TriangleSet::reserve(int count)
+{
+	for (Array<float>* array : { &m_v0x, &m_v0y, &m_v0z, &m_edge1x, &m_edge1y, &m_edge1z, &m_edge2x, &m_edge2y, &m_edge2z })
+	{
+		array->reserve(count + BatchSize - 1);
+	}
+}
+
+void TriangleSet::add(const vec3& v0, const vec3& v1, const vec3& v2)
+{
+	const vec3 edge1 = v1 - v0;
+	const vec3 edge2 = v2 - v0;
+	const float values[9] = { v0.x, v0.y, v0.z, edge1.x, edge1.y, edge1.z, edge2.x, edge2.y, edge2.z };
+
+	int i = 0;
+	for (Array<float>* array : { &m_v0x, &m_v0y, &m_v0z, &m_edge1x, &m_edge1y, &m_edge1z, &m_edge2x, &m_edge2y, &m_edge2z })
+	{
+		// Keep BatchSize - 1 zeros of padding after the last triangle. Zero edges never hit.
+		array->resize(m_count + BatchSize, 0.0f);
+		(*array)[m_count] = values[i++];
+	}
+	m_count++;
+}
+
+int TriangleSet::intersectScalar(const Ray& ray, int begin, int end, float t_min, float& t_max) const
+{
+	const vec3 origin = ray.origin();
+	const vec3 direction = ray.direction();
+	int hitIndex = -1;
+
+	for (int i = begin; i < end; ++i)
+	{
+		const vec3 edge1(m_edge1x[i], m_edge1y[i], m_edge1z[i]);
+		const vec3 edge2(m_edge2x[i], m_edge2y[i], m_edge2z[i]);
+		const vec3 r = glm::cross(direction, edge2);
+		const float a = glm::dot(edge1, r);
+		if (!(a > TriangleEpsilon))
+			continue; // Parallel or back facing
+
+		const vec3 s = origin - vec3(m_v0x[i], m_v0y[i], m_v0z[i]);
+		const float u = glm::dot(s, r);
+		if (u < 0.0f || u > a)
+			continue;
+
+		const vec3 q = glm::cross(s, edge1);
+		const float v = glm::dot(direction, q);
+		if (v < 0.0f || u + v > a)
+			continue;
+
+		const float t = (1.0f / a) * glm::dot(edge2, q);
+		if (t < t_max && t > t_min)
+		{
+			t_max = t;
+			hitIndex = i;
+		}
+	}
+	return hitIndex;
+}
+
+#ifdef RAE_SIMD_SCALAR
+
+int TriangleSet::intersect(const Ray& ray, int begin, int end, float t_min, float& t_max) const
+{
+	return intersectScalar(ray, begin, end, t_min, t_max);
+}
+
+#else
+
+int TriangleSet::intersect(const Ray& ray, int begin, int end, float t_min, float& t_max) const
+{
+	const vec3 rayOrigin = ray.origin();
+	const vec3 rayDirection = ray.direction();
+	const SimdFloat originX(rayOrigin.x), originY(rayOrigin.y), originZ(rayOrigin.z);
+	const SimdFloat directionX(rayDirection.x), directionY(rayDirection.y), directionZ(rayDirection.z);
+	const SimdFloat zero(0.0f);
+	const SimdFloat one(1.0f);
+	const SimdFloat epsilon(TriangleEpsilon);
+
+	int hitIndex = -1;
+	alignas(32) float distances[BatchSize];
+
+	for (int i = begin; i < end; i += BatchSize)
+	{
+		const SimdFloat edge1x = SimdFloat::load(&m_edge1x[i]);
+		const SimdFloat edge1y = SimdFloat::load(&m_edge1y[i]);
+		const SimdFloat edge1z = SimdFloat::load(&m_edge1z[i]);
+		const SimdFloat edge2x = SimdFloat::load(&m_edge2x[i]);
+		const SimdFloat edge2y = SimdFloat::load(&m_edge2y[i]);
+		const SimdFloat edge2z = SimdFloat::load(&m_edge2z[i]);
+
+		// The same operations in the same order as intersectScalar, so the results match exactly.
+		const SimdFloat rx = directionY * edge2z - edge2y * directionZ;
+		const SimdFloat ry = directionZ * edge2x - edge2z * directionX;
+		const SimdFloat rz = directionX * edge2y - edge2x * directionY;
+		const SimdFloat a = edge1x * rx + edge1y * ry + edge1z * rz;
+
+		const SimdFloat sx = originX - SimdFloat::load(&m_v0x[i]);
+		const SimdFloat sy = originY - SimdFloat::load(&m_v0y[i]);
+		const SimdFloat sz = originZ - SimdFloat::load(&m_v0z[i]);
+		const SimdFloat u = sx * rx + sy * ry + sz * rz;
+
+		// Many batches are back facing or miss already here.
+		if (moveMask((a > epsilon) & (u >= zero) & (u <= a)) == 0)
+			continue;
+
+		const SimdFloat qx = sy * edge1z - edge1y * sz;
+		const SimdFloat qy = sz * edge1x - edge1z * sx;
+		const SimdFloat qz = sx * edge1y - edge1x * sy;
+		const SimdFloat v = directionX * qx + directionY * qy + directionZ * qz;
+
+		int mask = moveMask((a > epsilon)
+			& (u >= zero) & (u <= a)
+			& (v >= zero) & ((u + v) <= a));
+		if (end - i < BatchSize)
+			mask &= (1 << (end - i)) - 1; // Lanes past the leaf belong to other leaves.
+		if (mask == 0)
+			continue;
+
+		const SimdFloat t = (one / a) * (edge2x * qx + edge2y * qy + edge2z * qz);
+		mask &= moveMask((t > SimdFloat(t_min)) & (t < SimdFloat(t_max)));
+		if (mask == 0)
+			continue;
+
+		// Go through the hits in order, like the scalar loop does, so ties resolve the same way.
+		t.store(distances);
+		for (int lane = 0; lane < BatchSize; ++lane)
+		{
+			if ((mask & (1 << lane)) && distances[lane] < t_max)
+			{
+				t_max = distances[lane];
+				hitIndex = i + lane;
+			}
+		}
+	}
+	return hitIndex;
+}
+
+#endif
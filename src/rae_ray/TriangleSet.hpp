@@ -0,0 +1,45 @@
+#pragma once
+
+#include "rae/core/Types.hpp"
+#include "rae/core/Simd.hpp"
+
+namespace rae
+{
+
+class Ray;
+
+// Triangles precomputed for ray intersection: the first vertex and the two edges from it,
+// stored as structure of arrays so that the SIMD kernel can test BatchSize triangles
+// against a ray at once. The arrays are padded so that a batch can always be loaded whole.
+class TriangleSet
+{
+public:
+	static const int BatchSize = SimdWidth;
+
+	void clear();
+	void reserve(int count);
+	void add(const vec3& v0, const vec3& v1, const vec3& v2);
+
+	int size() const { return m_count; }
+
+	// Möller-Trumbore against the front faces of triangles [begin, end). Returns the index of the
+	// closest triangle hit between t_min and t_max and sets t_max to its distance, or returns -1.
+	int intersect(const Ray& ray, int begin, int end, float t_min, float& t_max) const;
+	// The same one triangle at a time. Used when there is no SIMD and as a reference for it.
+	int intersectScalar(const Ray& ray, int begin, int end, float t_min, float& t_max) const;
+
+protected:
+	int m_count = 0;
+
+	Array<float> m_v0x;
+	Array<float> m_v0y;
+	Array<float> m_v0z;
+	Array<float> m_edge1x;
+	Array<float> m_edge1y;
+	Array<float> m_edge1z;
+	Array<float> m_edge2x;
+	Array<float> m_edge2y;
+	Array<float> m_edge2z;
+};
+
+}
@@ -0,0 +1,62 @@
+#include "rae/core/version.hpp"
+
+#ifdef version_catch
+#include "rae/core/catch.hpp"
+
+#include <cfloat>
+
+#include "rae/core/Random.hpp"
+#include "rae/visual/Mesh.hpp"
+#include "rae/visual/Ray.hpp"
+#include "rae_ray/HitRecord.hpp"
+#include "rae_ray/TriangleSet.hpp"
+
+using namespace rae;
+
+static vec3 randomPoint(float extent)
+{
+	return vec3(getRandom(-extent, extent), getRandom(-extent, extent), getRandom(-extent, extent));
+}
+
+SCENARIO("TriangleSet unittest", "[rae][TriangleSet]")
+{
+	GIVEN( "a soup of random triangles" )
+	{
+		TriangleSet triangles;
+		const int triangleCount = 203; // Not a multiple of the batch size
+		for (int i = 0; i < triangleCount; ++i)
+		{
+			vec3 center = randomPoint(2.0f);
+			triangles.add(center + randomPoint(0.5f), center + randomPoint(0.5f), center + randomPoint(0.5f));
+		}
+
+		REQUIRE(triangles.size() == triangleCount);
+
+		THEN( "the " + String(SimdName) + " kernel finds the same hits as the scalar one for any range" )
+		{
+			int mismatches = 0;
+			int hits = 0;
+			for (int i = 0; i < 2000; ++i)
+			{
+				Ray ray(randomPoint(4.0f), glm::normalize(randomPoint(1.0f)));
+				int begin = getRandomInt(0, triangleCount - 1);
+				int end = getRandomInt(begin + 1, triangleCount);
+
+				float simdDistance = FLT_MAX;
+				float scalarDistance = FLT_MAX;
+				int simdHit = triangles.intersect(ray, begin, end, 0.001f, simdDistance);
+				int scalarHit = triangles.intersectScalar(ray, begin, end, 0.001f, scalarDistance);
+
+				if (simdHit != scalarHit || simdDistance != scalarDistance)
+					mismatches++;
+				if (scalarHit != -1)
+					hits++;
+			}
+
+			REQUIRE(hits > 0);
+			REQUIRE(mismatches == 0);
+		}
+	}
+}
+
+#endif
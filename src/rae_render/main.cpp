@@ -0,0 +1,133 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define LOGURU_IMPLEMENTATION 1
+#include "loguru/loguru.hpp"
+
+#include "rae/core/ThreadPool.hpp"
+#include "rae_ray/OfflineRenderer.hpp"
+
+using namespace rae;
+
+// Renders a scene without a window, for batch renders and regression tests on build machines.
+
+static void printUsage()
+{
+	printf("Usage: rae_render [options]\n"
+		"  --scene N      1: scene one, 2: scene one with the bunny, 3: the scene from the book,\n"
+		"                 4: 1024 instances of the bunny. Default 1.\n"
+		"  --res WxH      Resolution. Default 640x360.\n"
+		"  --spp N        Samples per pixel. Default 16.\n"
+		"  --bounces N    Bounces limit. Default 50.\n"
+		"  --seed N       Random seed. The same seed gives the same image. Default 0.\n"
+		"  --threads N    Number of threads. Default one per hardware thread.\n"
+		"  --out NAME     Writes NAME.png and NAME.pfm. Default rae_render.\n");
+}
+
+int main(int argc, char** argv)
+{
+	loguru::init(argc, argv);
+
+	OfflineRenderSettings settings;
+	int threadCount = 0;
+	String outName = "rae_render";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* option = argv[i];
+		if (strcmp(option, "--help") == 0 || strcmp(option, "-h") == 0)
+		{
+			printUsage();
+			return 0;
+		}
+
+		if (i + 1 >= argc)
+		{
+			LOG_F(ERROR, "Missing the value of %s.", option);
+			printUsage();
+			return 1;
+		}
+		const char* value = argv[++i];
+
+		if (strcmp(option, "--scene") == 0)
+			settings.scene = atoi(value);
+		else if (strcmp(option, "--res") == 0)
+		{
+			if (sscanf(value, "%ix%i", &settings.width, &settings.height) != 2)
+				settings.width = 0;
+		}
+		else if (strcmp(option, "--spp") == 0)
+			settings.samplesPerPixel = atoi(value);
+		else if (strcmp(option, "--bounces") == 0)
+			settings.bouncesLimit = atoi(value);
+		else if (strcmp(option, "--seed") == 0)
+			settings.seed = strtoull(value, nullptr, 10);
+		else if (strcmp(option, "--threads") == 0)
+			threadCount = atoi(value);
+		else if (strcmp(option, "--out") == 0)
+			outName = value;
+		else
+		{
+			LOG_F(ERROR, "Unknown option: %s", option);
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (OfflineRenderer::isValidScene(settings.scene) == false || settings.width <= 0 || settings.height <= 0
+		|| settings.samplesPerPixel <= 0 || settings.bouncesLimit < 0 || threadCount < 0)
+	{
+		LOG_F(ERROR, "Invalid options.");
+		printUsage();
+		return 1;
+	}
+
+	// The thread that renders helps the workers.
+	if (threadCount > 0)
+		setThreadPoolWorkerCount(threadCount - 1);
+
+	OfflineRenderer renderer(settings);
+	renderer.createScene();
+	renderer.render();
+
+	const OfflineRenderStats& stats = renderer.stats();
+	const double seconds = stats.renderTimeMs / 1000.0;
+	printf("Scene %i at %ix%i, %i spp, %i bounces, seed %llu, %i threads\n",
+		settings.scene, settings.width, settings.height, settings.samplesPerPixel, settings.bouncesLimit,
+		(unsigned long long)settings.seed, stats.threadCount);
+	printf("Scene created in %f ms, BVH built in %f ms\n", stats.sceneTimeMs, stats.bvhBuildTimeMs);
+	printf("Rendered in %f s: %f Msamples/s, %f Mrays/s (%lld rays)\n", seconds,
+		double(stats.sampleCount) / seconds / 1.0e6, double(stats.rayCount()) / seconds / 1.0e6,
+		(long long)stats.rayCount());
+	if (RayStats::IsEnabled)
+	{
+		const RayStats& rayStats = stats.rayStats;
+		printf("Per sample: %f BVH nodes, %f AABB tests, %f sphere tests, %f triangle tests, path length %f\n",
+			rayStats.average(rayStats.bvhNodeCount), rayStats.average(rayStats.aabbTestCount),
+			rayStats.average(rayStats.sphereTestCount), rayStats.average(rayStats.triangleTestCount),
+			rayStats.average(rayStats.bounceCount));
+	}
+
+	bool isWritten = true;
+	const String pngName = outName + ".png";
+	if (renderer.writePng(pngName))
+		printf("Wrote %s\n", pngName.c_str());
+	else
+	{
+		LOG_F(ERROR, "Failed to write %s", pngName.c_str());
+		isWritten = false;
+	}
+
+	const String pfmName = outName + ".pfm";
+	if (renderer.writePfm(pfmName))
+		printf("Wrote %s\n", pfmName.c_str());
+	else
+	{
+		LOG_F(ERROR, "Failed to write %s", pfmName.c_str());
+		isWritten = false;
+	}
+
+	return isWritten ? 0 : 1;
+}